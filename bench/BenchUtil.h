@@ -0,0 +1,54 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+// Utilidades comunes de los benchmarks de bench/: opciones --nombre=valor y
+// la cabecera con las CPUs disponibles, que hay que citar junto a los números.
+namespace Bench {
+
+// Valor de --name=... en argv; fallback si no aparece
+inline std::string option(int argc, char* argv[], const std::string& name, const std::string& fallback) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], prefix.c_str(), prefix.size()) == 0) return argv[i] + prefix.size();
+    }
+    return fallback;
+}
+
+inline size_t sizeOption(int argc, char* argv[], const std::string& name, size_t fallback) {
+    std::string value = option(argc, argv, name, "");
+    return value.empty() ? fallback : std::strtoull(value.c_str(), nullptr, 10);
+}
+
+// "1,8,64" -> {1, 8, 64}
+inline std::vector<size_t> listOption(int argc, char* argv[], const std::string& name, const std::string& fallback) {
+    std::string text = option(argc, argv, name, fallback);
+    std::vector<size_t> values;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        values.push_back(std::strtoull(text.substr(start, comma - start).c_str(), nullptr, 10));
+        start = comma + 1;
+    }
+    return values;
+}
+
+inline void header(const char* name) {
+    std::cout << "== " << name << " (" << std::thread::hardware_concurrency() << " CPU(s))" << std::endl;
+}
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace Bench
+
+#endif
@@ -0,0 +1,101 @@
+// user-008: bytes/s de historial servido como JSON (/api/messages, initial_state).
+// Compara el camino anterior, un crow::json::wvalue por mensaje y dump(), con
+// JsonUtil::Writer, que escribe todo en un solo buffer reservado de antemano.
+//
+// Uso: bench_history_json [--messages=20000] [--rounds=20]
+
+#include "../include/crow_all.h"
+#include "BenchUtil.h"
+#include "MessageLog.h"
+#include "JsonUtil.h"
+#include <cstdio>
+
+namespace {
+
+// Lo que hacía main.cpp antes de user-008, con los campos actuales
+crow::json::wvalue messageToJson(const Message& msg) {
+    crow::json::wvalue m;
+    m["seq"] = msg.seq;
+    m["id"] = msg.id;
+    m["type"] = msg.isFile() ? "file" : "text";
+    m["content"] = std::string(msg.content());
+    m["timestamp"] = msg.timestamp_ms;
+    m["sender_ip"] = msg.sender_ip.toString();
+    if (msg.isFile()) {
+        m["filename"] = std::string(msg.filename());
+        m["filesize"] = msg.filesize;
+    }
+    return m;
+}
+
+std::string wvaluePage(const MessagePage& messages) {
+    crow::json::wvalue list = crow::json::wvalue::list();
+    for (size_t i = 0; i < messages.size(); i++) {
+        list[i] = messageToJson(*messages[i]);
+    }
+    crow::json::wvalue page;
+    page["messages"] = std::move(list);
+    page["next_since"] = messages.empty() ? 0 : messages.back()->seq;
+    page["has_more"] = false;
+    return page.dump();
+}
+
+std::string writerPage(const MessagePage& messages) {
+    JsonUtil::Writer json;
+    json.beginObject()
+        .key("messages").messages(messages)
+        .key("next_since").value(messages.empty() ? uint64_t(0) : messages.back()->seq)
+        .key("has_more").value(false)
+        .endObject();
+    return json.take();
+}
+
+template<typename Page>
+void measure(const char* name, const MessagePage& messages, size_t rounds, Page page) {
+    std::string body = page(messages);  // calentar
+    auto parsed = crow::json::load(body);
+    if (!parsed || parsed["messages"].size() != messages.size()) {
+        std::cerr << "❌ " << name << ": JSON inválido" << std::endl;
+        return;
+    }
+
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) bytes += page(messages).size();
+    double seconds = Bench::secondsSince(start);
+    printf("%-8s %10zu bytes/respuesta %8.2f ms/respuesta %8.1f MB/s\n", name, body.size(),
+           seconds * 1000 / rounds, bytes / seconds / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = Bench::sizeOption(argc, argv, "messages", 20000);
+    size_t rounds = Bench::sizeOption(argc, argv, "rounds", 20);
+
+    // Texto con caracteres a escapar y algún archivo, como un historial real
+    MessageLog log;
+    IpAddress ip = IpAddress::parse("192.168.1.23");
+    for (size_t i = 0; i < count; i++) {
+        std::string content = "mensaje de prueba número " + std::to_string(i) + " con \"comillas\", \\ y\nsalto";
+        std::string filename = std::to_string(i) + "_informe.pdf";
+        MessageDraft draft;
+        draft.sender_ip = ip;
+        if (i % 10 == 0) {
+            draft.type = MessageType::File;
+            draft.content = "informe.pdf";
+            draft.filename = filename;
+            draft.filesize = 123456;
+        } else {
+            draft.content = content;
+        }
+        log.append(draft);
+    }
+    auto messages = log.since(0);
+
+    Bench::header("history_json");
+    std::cout << messages.size() << " mensajes" << std::endl;
+    measure("wvalue", messages, rounds, wvaluePage);
+    measure("Writer", messages, rounds, writerPage);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// user-018: coste de insertar un mensaje con id y hora en texto (antes) frente
+// a id snowflake y epoch en ms (MessageLog::append).
+//
+// Uso: bench_message_ids [--threads=1,4] [--messages=1000000]
+// "antes" reproduce addTextMessage anterior a user-018: bajo el mutex de
+// FileManager, generateId (system_clock + mt19937 + dos to_string) y
+// getCurrentTimestamp (std::localtime + stringstream + put_time), y un
+// Message con sus std::string en un vector.
+
+#include "BenchUtil.h"
+#include "MessageLog.h"
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <cstdio>
+
+namespace {
+
+class OldLog {
+public:
+    void append(const std::string& text, const std::string& sender_ip) {
+        std::lock_guard<std::mutex> lock(mtx);
+        OldMessage msg;
+        msg.id = generateId();
+        msg.type = "text";
+        msg.content = text;
+        msg.timestamp = getCurrentTimestamp();
+        msg.sender_ip = sender_ip;
+        messages.push_back(std::move(msg));
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return messages.size();
+    }
+
+private:
+    struct OldMessage {
+        std::string id;
+        std::string type;
+        std::string content;
+        std::string timestamp;
+        std::string sender_ip;
+        size_t filesize = 0;
+    };
+    std::mutex mtx;
+    std::vector<OldMessage> messages;
+
+    std::string generateId() {
+        static std::random_device rd;
+        static std::mt19937 gen(rd());
+        static std::uniform_int_distribution<> dis(100000, 999999);
+        auto now = std::chrono::system_clock::now().time_since_epoch().count();
+        return std::to_string(now) + "_" + std::to_string(dis(gen));
+    }
+
+    std::string getCurrentTimestamp() {
+        auto now = std::chrono::system_clock::now();
+        auto time_t_now = std::chrono::system_clock::to_time_t(now);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
+        ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+        return ss.str();
+    }
+};
+
+// ns por mensaje con `threads` hilos insertando `total` mensajes entre todos
+template<typename Insert>
+double run(size_t threads, size_t total, Insert insert) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < total; i += threads) insert();
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    return Bench::secondsSince(start) * 1e9 / total;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto thread_counts = Bench::listOption(argc, argv, "threads", "1,4");
+    size_t total = Bench::sizeOption(argc, argv, "messages", 1000000);
+
+    const std::string text = "mensaje de prueba con algo de texto";
+    const std::string sender_ip = "192.168.1.23";
+    MessageDraft draft;
+    draft.content = text;
+    draft.sender_ip = IpAddress::parse(sender_ip);
+
+    Bench::header("message_ids");
+    printf("%6s %16s %16s\n", "hilos", "antes ns/msg", "ahora ns/msg");
+    for (size_t threads : thread_counts) {
+        OldLog old_log;
+        double before = run(threads, total, [&] { old_log.append(text, sender_ip); });
+        MessageLog log;
+        double after = run(threads, total, [&] { log.append(draft); });
+        if (old_log.size() != total || log.size() != total) {
+            std::cerr << "❌ faltan mensajes" << std::endl;
+            return 1;
+        }
+        printf("%6zu %16.0f %16.0f\n", threads, before, after);
+    }
+    return 0;
+}
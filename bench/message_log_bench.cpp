@@ -0,0 +1,155 @@
+// user-007: lectores del historial con un escritor publicando a la vez.
+// Compara MessageLog (segmentos publicados con atomics) con el diseño anterior:
+// un mutex compartido por lectores y escritor y un shared_ptr por mensaje.
+//
+// Uso: bench_message_log [--readers=1,8,64] [--seconds=2] [--retain=50000] [--page=50]
+// Cada lector pide los últimos `page` mensajes en bucle; el escritor publica sin
+// parar y recorta el principio para quedarse en `retain` (como la retención).
+// Los números solo dicen algo de la contención con tantas CPUs como lectores.
+
+#include "BenchUtil.h"
+#include "MessageLog.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <cstdio>
+
+namespace {
+
+// Historial anterior a user-007 (deque en lugar de vector para poder recortar
+// el principio en O(1); el lock es el mismo)
+class MutexLog {
+public:
+    void append(const MessageDraft& draft) {
+        auto owned = std::make_shared<Owned>();
+        owned->strings.append(draft.content).append(draft.filename).append(draft.sha256);
+        owned->msg.strings = owned->strings.data();
+        owned->msg.content_size = static_cast<uint32_t>(draft.content.size());
+        owned->msg.sender_ip = draft.sender_ip;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        owned->msg.seq = floor + messages.size() + 1;
+        messages.push_back(MessagePtr(owned, &owned->msg));
+    }
+
+    uint64_t last() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return floor + messages.size();
+    }
+
+    std::vector<MessagePtr> since(uint64_t seq, size_t limit) {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t first = seq > floor ? std::min<size_t>(seq - floor, messages.size()) : 0;
+        size_t end = std::min(messages.size(), first + limit);
+        return std::vector<MessagePtr>(messages.begin() + first, messages.begin() + end);
+    }
+
+    void trim(uint64_t up_to) {
+        std::lock_guard<std::mutex> lock(mtx);
+        while (floor < up_to && !messages.empty()) {
+            messages.pop_front();
+            floor++;
+        }
+    }
+
+private:
+    struct Owned {
+        Message msg;
+        std::string strings;
+    };
+    std::mutex mtx;
+    std::deque<MessagePtr> messages;
+    uint64_t floor = 0;
+};
+
+struct Result {
+    double reads_per_second;
+    double writes_per_second;
+};
+
+template<typename Log>
+void fill(Log& log, size_t count) {
+    static const std::string content = "mensaje de prueba con algo de texto";
+    MessageDraft draft;
+    draft.content = content;
+    draft.sender_ip = IpAddress::parse("192.168.1.23");
+    for (size_t i = 0; i < count; i++) log.append(draft);
+}
+
+// Coste de una página en un solo hilo, sin escritor: comparable en cualquier máquina
+template<typename Log>
+double pageNanoseconds(size_t retain, size_t page) {
+    Log log;
+    fill(log, retain);
+    const size_t calls = 1000000;
+    size_t seen = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; i++) {
+        seen += log.since(log.last() - page, page).size();
+    }
+    double ns = Bench::secondsSince(start) * 1e9 / calls;
+    return seen == calls * page ? ns : -1;
+}
+
+template<typename Log>
+Result run(size_t readers, double seconds, size_t retain, size_t page) {
+    Log log;
+    fill(log, retain);
+    std::string content = "mensaje de prueba con algo de texto";
+    MessageDraft draft;
+    draft.content = content;
+    draft.sender_ip = IpAddress::parse("192.168.1.23");
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    uint64_t writes = 0;
+
+    std::thread writer([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            log.append(draft);
+            if (++writes % MessageLog::SEGMENT_SIZE == 0) log.trim(log.last() - retain);
+        }
+    });
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            uint64_t done = 0;
+            size_t seen = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint64_t last = log.last();
+                auto messages = log.since(last > page ? last - page : 0, page);
+                seen += messages.size();
+                done++;
+            }
+            reads += done;
+            if (done > 0 && seen == 0) std::cerr << "⚠️  un lector no vio ningún mensaje" << std::endl;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    writer.join();
+    for (auto& thread : threads) thread.join();
+    return {reads / seconds, writes / seconds};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto readers = Bench::listOption(argc, argv, "readers", "1,8,64");
+    double seconds = static_cast<double>(Bench::sizeOption(argc, argv, "seconds", 2));
+    size_t retain = Bench::sizeOption(argc, argv, "retain", 50000);
+    size_t page = Bench::sizeOption(argc, argv, "page", 50);
+
+    Bench::header("message_log");
+    printf("página de %zu sin contención: mutex %.0f ns, MessageLog %.0f ns\n", page,
+           pageNanoseconds<MutexLog>(retain, page), pageNanoseconds<MessageLog>(retain, page));
+    printf("%8s %18s %14s %18s %14s\n", "lectores", "mutex lecturas/s", "escrituras/s", "MessageLog lect/s", "escrituras/s");
+    for (size_t count : readers) {
+        Result mutex = run<MutexLog>(count, seconds, retain, page);
+        Result log = run<MessageLog>(count, seconds, retain, page);
+        printf("%8zu %18.0f %14.0f %18.0f %14.0f\n", count,
+               mutex.reads_per_second, mutex.writes_per_second, log.reads_per_second, log.writes_per_second);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// user-002: latencia de addTextMessage mientras otros hilos suben archivos
+// grandes, frente al servidor sin subidas.
+//
+// Uso: bench_text_latency [--uploaders=0,4] [--file-mb=64] [--messages=20000] [--interval-us=100]
+// Cada "subida" hace lo mismo que /api/uploads: escribe el staging en
+// temp_dir por trozos de 64 KB calculando el SHA-256 y lo publica con
+// addFileMessageFromStaging; después se aplica la retención para que el disco
+// no crezca. Los logs de FileManager van a std::cout y se descartan durante
+// la medida, así que los números no incluyen la consola.
+
+#include "BenchUtil.h"
+#include "FileManager.h"
+#include "Sha256.h"
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+namespace {
+
+const size_t CHUNK_BYTES = 64 * 1024;
+
+struct Result {
+    std::vector<double> latencies_us;
+    size_t uploads = 0;
+    double upload_mb_s = 0;
+};
+
+// Escribe un staging de `bytes` con contenido distinto en cada subida (si no,
+// el almacén lo detecta como repetido y no toca el disco) y lo publica
+bool upload(FileManager& files, const std::string& path, size_t bytes, uint64_t tag) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    std::vector<unsigned char> chunk(CHUNK_BYTES);
+    Sha256 hasher;
+    size_t written = 0;
+    while (written < bytes) {
+        size_t n = std::min(CHUNK_BYTES, bytes - written);
+        for (size_t i = 0; i < n; i += 8) {
+            uint64_t word = tag ^ ((written + i) * 0x9E3779B97F4A7C15ULL);
+            memcpy(chunk.data() + i, &word, std::min<size_t>(8, n - i));
+        }
+        if (::write(fd, chunk.data(), n) != static_cast<ssize_t>(n)) {
+            ::close(fd);
+            return false;
+        }
+        hasher.update(chunk.data(), n);
+        written += n;
+    }
+    ::close(fd);
+    return files.addFileMessageFromStaging("bench.bin", path, bytes, "192.168.1.50", hasher.finish()) != nullptr;
+}
+
+Result run(FileManager& files, size_t uploaders, size_t file_bytes, size_t messages, size_t interval_us) {
+    Result result;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> uploads{0};
+    std::mutex retention_mtx;  // enforceRetention lo llama un solo hilo
+    FileManager::RetentionLimits limits;
+    limits.max_bytes = static_cast<uint64_t>(file_bytes) * (uploaders + 1);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < uploaders; t++) {
+        workers.emplace_back([&, t] {
+            std::string path = files.getTempDir() + "/.upload_bench_" + std::to_string(t);
+            for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); i++) {
+                if (!upload(files, path, file_bytes, (static_cast<uint64_t>(t) << 48) | (i + 1))) {
+                    std::cerr << "❌ subida fallida: " << path << std::endl;
+                    return;
+                }
+                uploads.fetch_add(1);
+                std::lock_guard<std::mutex> lock(retention_mtx);
+                files.enforceRetention(limits);
+            }
+        });
+    }
+
+    // Con subidas en marcha se mide desde que empiezan a escribir
+    if (uploaders > 0) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    result.latencies_us.reserve(messages);
+    for (size_t i = 0; i < messages; i++) {
+        auto sent = std::chrono::steady_clock::now();
+        if (!files.addTextMessage("mensaje de prueba con algo de texto", "192.168.1.23")) {
+            std::cerr << "❌ mensaje descartado" << std::endl;
+            break;
+        }
+        result.latencies_us.push_back(Bench::secondsSince(sent) * 1e6);
+        if (interval_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+    }
+    stop = true;
+    for (auto& worker : workers) worker.join();
+
+    double seconds = Bench::secondsSince(start);
+    result.uploads = uploads.load();
+    result.upload_mb_s = result.uploads * (file_bytes / 1048576.0) / seconds;
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto uploader_counts = Bench::listOption(argc, argv, "uploaders", "0,4");
+    size_t file_bytes = Bench::sizeOption(argc, argv, "file-mb", 64) * 1048576;
+    size_t messages = Bench::sizeOption(argc, argv, "messages", 20000);
+    size_t interval_us = Bench::sizeOption(argc, argv, "interval-us", 100);
+
+    Bench::header("text_latency");
+    printf("%9s %9s %10s %10s %10s %10s %12s\n",
+           "subidas", "archivos", "p50 us", "p99 us", "p99.9 us", "max us", "subida MB/s");
+    for (size_t uploaders : uploader_counts) {
+        // Silencia los logs de FileManager (printf no pasa por std::cout)
+        std::streambuf* console = std::cout.rdbuf(nullptr);
+        Result result;
+        {
+            FileManager files;
+            result = run(files, uploaders, file_bytes, messages, interval_us);
+        }
+        std::cout.rdbuf(console);
+        std::cout.clear();
+        printf("%9zu %9zu %10.1f %10.1f %10.1f %10.1f %12.0f\n", uploaders, result.uploads,
+               percentile(result.latencies_us, 0.50), percentile(result.latencies_us, 0.99),
+               percentile(result.latencies_us, 0.999), result.latencies_us.empty() ? 0.0 : result.latencies_us.back(),
+               result.upload_mb_s);
+        fflush(stdout);
+    }
+    return 0;
+}
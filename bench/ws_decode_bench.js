@@ -0,0 +1,46 @@
+// user-011: coste de decodificar initial_state en el navegador, binario frente a
+// JSON.parse, con el decodificador de src/view/js/app.js tal cual.
+//
+// Uso: node ws_decode_bench.js <dir>   (frames de bench_ws_encoding --frames=<dir>)
+// Comprueba también que los dos caminos dan los mismos objetos.
+
+const fs = require('fs');
+const path = require('path');
+
+const dir = process.argv[2];
+if (!dir) {
+    console.error('uso: node ws_decode_bench.js <dir con initial_state.json/.bin>');
+    process.exit(2);
+}
+
+// El decodificador va de "const textDecoder" hasta la función siguiente
+const source = fs.readFileSync(path.join(__dirname, '../src/view/js/app.js'), 'utf8');
+const start = source.indexOf('const textDecoder');
+const end = source.indexOf('// Pide por HTTP');
+if (start < 0 || end < start) {
+    console.error('❌ No se encuentra decodeBinaryEvent en app.js');
+    process.exit(1);
+}
+const decodeBinaryEvent = new Function(source.slice(start, end) + '\nreturn decodeBinaryEvent;')();
+
+const binary = fs.readFileSync(path.join(dir, 'initial_state.bin'));
+const buffer = binary.buffer.slice(binary.byteOffset, binary.byteOffset + binary.length);
+const json = fs.readFileSync(path.join(dir, 'initial_state.json'), 'utf8');
+
+const normalize = (messages) => JSON.stringify(messages.map((m) => Object.fromEntries(Object.entries(m).sort())));
+const fromBinary = decodeBinaryEvent(buffer).messages;
+const fromJson = JSON.parse(json).messages;
+if (normalize(fromBinary) !== normalize(fromJson)) {
+    console.error('❌ El binario y el JSON no decodifican a los mismos mensajes');
+    process.exit(1);
+}
+
+console.log(`== ws_decode (${fromJson.length} mensajes, JSON ${Buffer.byteLength(json)} B, binario ${binary.length} B)`);
+for (const [name, decode] of [['JSON.parse', () => JSON.parse(json)], ['binario', () => decodeBinaryEvent(buffer)]]) {
+    for (let i = 0; i < 5; i++) decode();
+    const rounds = 20;
+    const begin = process.hrtime.bigint();
+    for (let i = 0; i < rounds; i++) decode();
+    const ms = Number(process.hrtime.bigint() - begin) / rounds / 1e6;
+    console.log(`${name.padEnd(12)} ${ms.toFixed(1)} ms`);
+}
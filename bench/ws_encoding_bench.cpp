@@ -0,0 +1,95 @@
+// user-011: coste de codificar y tamaño en la red del protocolo binario de /ws
+// frente al JSON, para initial_state y para un new_message suelto.
+//
+// Uso: bench_ws_encoding [--messages=20000] [--rounds=20] [--frames=<dir>]
+// Con --frames escribe initial_state.json e initial_state.bin en <dir> para
+// ws_decode_bench.js, que mide la decodificación con el código de app.js
+// (target bench_ws_decode si hay node).
+
+#include "BenchUtil.h"
+#include "MessageLog.h"
+#include "JsonUtil.h"
+#include "BinaryProtocol.h"
+#include <fstream>
+#include <cstdio>
+
+namespace {
+
+std::string jsonInitialState(const MessagePage& messages) {
+    JsonUtil::Writer json;
+    json.beginObject()
+        .key("type").value("initial_state")
+        .key("since").value(0)
+        .key("messages").messages(messages)
+        .endObject();
+    return json.take();
+}
+
+std::string jsonNewMessage(const Message& msg) {
+    JsonUtil::Writer json;
+    json.beginObject()
+        .key("type").value("new_message")
+        .key("message").value(msg)
+        .endObject();
+    return json.take();
+}
+
+template<typename Encode>
+void measure(const char* name, size_t rounds, size_t per_round, Encode encode) {
+    size_t bytes = encode();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; i++) encode();
+    double seconds = Bench::secondsSince(start);
+    printf("%-22s %10zu bytes %10.0f ns/mensaje %8.2f ms/ronda\n", name, bytes,
+           seconds * 1e9 / (rounds * per_round), seconds * 1000 / rounds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = Bench::sizeOption(argc, argv, "messages", 20000);
+    size_t rounds = Bench::sizeOption(argc, argv, "rounds", 20);
+    std::string frames_dir = Bench::option(argc, argv, "frames", "");
+
+    // Texto con escapes y no ASCII (los largos binarios van en UTF-16) y algún archivo
+    MessageLog log;
+    IpAddress ip = IpAddress::parse("192.168.1.23");
+    for (size_t i = 0; i < count; i++) {
+        std::string content = "mensaje de prueba número " + std::to_string(i) + " con \"comillas\", \\ y\nsalto ✓";
+        std::string filename = std::to_string(i) + "_informe.pdf";
+        MessageDraft draft;
+        draft.sender_ip = ip;
+        if (i % 10 == 0) {
+            draft.type = MessageType::File;
+            draft.content = "informe.pdf";
+            draft.filename = filename;
+            draft.filesize = 123456;
+        } else {
+            draft.content = content;
+        }
+        log.append(draft);
+    }
+    auto messages = log.since(0);
+
+    Bench::header("ws_encoding");
+    std::cout << messages.size() << " mensajes" << std::endl;
+    measure("initial_state JSON", rounds, messages.size(), [&] { return jsonInitialState(messages).size(); });
+    measure("initial_state binario", rounds, messages.size(), [&] { return BinaryProtocol::initialState(0, messages).size(); });
+    measure("new_message JSON", rounds, messages.size(), [&] {
+        size_t bytes = 0;
+        for (const auto& msg : messages) bytes += jsonNewMessage(*msg).size();
+        return bytes;
+    });
+    measure("new_message binario", rounds, messages.size(), [&] {
+        size_t bytes = 0;
+        for (const auto& msg : messages) bytes += BinaryProtocol::newMessage(*msg).size();
+        return bytes;
+    });
+
+    if (!frames_dir.empty()) {
+        std::ofstream(frames_dir + "/initial_state.json", std::ios::binary) << jsonInitialState(messages);
+        std::ofstream(frames_dir + "/initial_state.bin", std::ios::binary) << BinaryProtocol::initialState(0, messages);
+        std::cout << "Frames escritos en " << frames_dir << std::endl;
+    }
+    return 0;
+}
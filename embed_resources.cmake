@@ -1,10 +1,23 @@
 # Script para embeber múltiples recursos como strings en C++
+#
+# Además del contenido genera, por recurso:
+#   - una huella (16 primeros hex del SHA-256) y la ruta con huella
+#     (/js/app.js -> /js/app.<huella>.js) que se puede cachear para siempre
+#   - las variantes gzip (GZIP) y brotli (BROTLI) si las herramientas existen
+#     y la variante sale más pequeña que el original
+#   - una ETag fuerte por variante
+# Las referencias entre recursos ("/js/app.js" en index.html) se reescriben a la
+# ruta con huella, así un cambio en app.js cambia también la huella de quien lo usa.
+# Todo es constexpr: los tipos y la tabla de hash perfecto están en
+# src/EmbeddedResources.h, aquí solo se emiten los datos y las entradas.
 
 # DEBUG: Imprimir lo que recibimos
 message(STATUS "=== EMBED RESOURCES DEBUG ===")
 message(STATUS "RESOURCE_FILES recibido: ${RESOURCE_FILES}")
 message(STATUS "SOURCE_DIR: ${SOURCE_DIR}")
 message(STATUS "OUTPUT_FILE: ${OUTPUT_FILE}")
+message(STATUS "GZIP: ${GZIP}")
+message(STATUS "BROTLI: ${BROTLI}")
 
 # Separar correctamente la lista de archivos
 separate_arguments(RESOURCE_LIST UNIX_COMMAND "${RESOURCE_FILES}")
@@ -28,15 +41,18 @@ message(STATUS "Total archivos válidos: ${FILE_COUNT}")
 if(FILE_COUNT EQUAL 0)
     message(WARNING "⚠️  No se encontraron archivos válidos")
     # Crear header vacío
-    file(WRITE "${OUTPUT_FILE}" 
+    file(WRITE "${OUTPUT_FILE}"
 "#ifndef EMBEDDED_RESOURCES_H
 #define EMBEDDED_RESOURCES_H
-#include <string>
-#include <unordered_map>
+#include \"EmbeddedResources.h\"
 namespace Resources {
-    struct Resource { const char* content; const char* mime_type; };
-    const std::unordered_map<std::string, Resource> RESOURCE_MAP = {};
-    inline const Resource* getResource(const std::string&) { return nullptr; }
+    constexpr size_t RESOURCE_COUNT = 0;
+    inline constexpr PerfectHashTable<0> RESOURCE_TABLE{std::array<Entry, 0>{}};
+    inline const Entry* findResource(std::string_view path) { return RESOURCE_TABLE.find(path); }
+    inline const Resource* getResource(std::string_view path) {
+        const Entry* entry = findResource(path);
+        return entry ? entry->resource : nullptr;
+    }
 }
 #endif
 ")
@@ -53,6 +69,18 @@ function(path_to_varname filepath outvar)
     set(${outvar} "${var_name}" PARENT_SCOPE)
 endfunction()
 
+# Función para obtener la ruta web (/js/app.js)
+function(path_to_webpath filepath outvar)
+    string(REPLACE "${SOURCE_DIR}/src/view/" "" web_path "${filepath}")
+    string(REPLACE "${SOURCE_DIR}/src/view" "" web_path "${web_path}")
+
+    # Normalizar la ruta web
+    if(NOT web_path MATCHES "^/")
+        set(web_path "/${web_path}")
+    endif()
+    set(${outvar} "${web_path}" PARENT_SCOPE)
+endfunction()
+
 # Función para obtener tipo MIME
 function(get_mime_type filepath outvar)
     if(filepath MATCHES "\\.html$")
@@ -68,86 +96,201 @@ function(get_mime_type filepath outvar)
     endif()
 endfunction()
 
+# Comprime INPUT con TOOL (y los argumentos que siguen) y deja en outvar el
+# array C con los bytes y en outsize su tamaño; 0 si no hay TOOL o no compensa
+function(compress_resource TOOL INPUT ORIGINAL_SIZE outvar outsize)
+    set(${outvar} "" PARENT_SCOPE)
+    set(${outsize} 0 PARENT_SCOPE)
+    if(NOT TOOL)
+        return()
+    endif()
+
+    execute_process(COMMAND ${TOOL} ${ARGN} "${INPUT}"
+                    OUTPUT_FILE "${INPUT}.out"
+                    RESULT_VARIABLE RESULT)
+    if(NOT RESULT EQUAL 0)
+        message(WARNING "⚠️  ${TOOL} falló con ${INPUT}")
+        return()
+    endif()
+
+    file(SIZE "${INPUT}.out" SIZE)
+    # Menos del 90%: si no, no merece la pena descomprimir en el cliente
+    math(EXPR LIMIT "${ORIGINAL_SIZE} * 9 / 10")
+    if(SIZE EQUAL 0 OR SIZE GREATER_EQUAL LIMIT)
+        return()
+    endif()
+
+    file(READ "${INPUT}.out" HEX HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," BYTES "${HEX}")
+    set(${outvar} "${BYTES}" PARENT_SCOPE)
+    set(${outsize} ${SIZE} PARENT_SCOPE)
+endfunction()
+
+# Huellas en orden de dependencias: un recurso se procesa cuando todos los que
+# referencia ya tienen la suya
+foreach(RESOURCE_FILE ${VALID_FILES})
+    path_to_webpath("${RESOURCE_FILE}" WEB_PATH)
+    file(READ "${RESOURCE_FILE}" CONTENT_${WEB_PATH})
+endforeach()
+
+set(PENDING ${VALID_FILES})
+set(ORDERED "")
+while(PENDING)
+    set(PROGRESS FALSE)
+    foreach(RESOURCE_FILE ${PENDING})
+        path_to_webpath("${RESOURCE_FILE}" WEB_PATH)
+        set(READY TRUE)
+        foreach(OTHER_FILE ${PENDING})
+            path_to_webpath("${OTHER_FILE}" OTHER_PATH)
+            if(NOT OTHER_PATH STREQUAL WEB_PATH)
+                string(FIND "${CONTENT_${WEB_PATH}}" "${OTHER_PATH}" FOUND)
+                if(NOT FOUND EQUAL -1)
+                    set(READY FALSE)
+                endif()
+            endif()
+        endforeach()
+        if(READY)
+            list(APPEND ORDERED "${RESOURCE_FILE}")
+            list(REMOVE_ITEM PENDING "${RESOURCE_FILE}")
+            set(PROGRESS TRUE)
+        endif()
+    endforeach()
+    if(NOT PROGRESS)
+        message(WARNING "⚠️  Referencias circulares entre recursos: ${PENDING}")
+        list(APPEND ORDERED ${PENDING})
+        set(PENDING "")
+    endif()
+endwhile()
+
+set(HASHED_PATHS "")
+foreach(RESOURCE_FILE ${ORDERED})
+    path_to_webpath("${RESOURCE_FILE}" WEB_PATH)
+    set(CONTENT "${CONTENT_${WEB_PATH}}")
+
+    # Referencias (entre comillas) a recursos ya procesados -> ruta con huella
+    foreach(PAIR ${HASHED_PATHS})
+        string(REPLACE "=" ";" PAIR "${PAIR}")
+        list(GET PAIR 0 FROM)
+        list(GET PAIR 1 TO)
+        string(REPLACE "\"${FROM}\"" "\"${TO}\"" CONTENT "${CONTENT}")
+        string(REPLACE "'${FROM}'" "'${TO}'" CONTENT "${CONTENT}")
+    endforeach()
+    set(CONTENT_${WEB_PATH} "${CONTENT}")
+
+    string(SHA256 HASH "${CONTENT}")
+    string(SUBSTRING "${HASH}" 0 16 HASH_${WEB_PATH})
+
+    # Los .html son puntos de entrada: su URL no cambia
+    if(WEB_PATH MATCHES "\\.html$")
+        set(HASHED_PATH_${WEB_PATH} "")
+    else()
+        string(REGEX REPLACE "\\.([^./]+)$" ".${HASH_${WEB_PATH}}.\\1" HASHED_PATH_${WEB_PATH} "${WEB_PATH}")
+        list(APPEND HASHED_PATHS "${WEB_PATH}=${HASHED_PATH_${WEB_PATH}}")
+    endif()
+endforeach()
+
 # Iniciar archivo header
-file(WRITE "${OUTPUT_FILE}" 
+file(WRITE "${OUTPUT_FILE}"
 "// AUTO-GENERADO POR CMAKE - NO EDITAR MANUALMENTE
 #ifndef EMBEDDED_RESOURCES_H
 #define EMBEDDED_RESOURCES_H
 
-#include <string>
-#include <unordered_map>
+#include \"EmbeddedResources.h\"
 
 namespace Resources {
 
-// Estructura para almacenar recursos
-struct Resource {
-    const char* content;
-    const char* mime_type;
-};
-
 ")
 
+get_filename_component(OUTPUT_DIR "${OUTPUT_FILE}" DIRECTORY)
+set(WORK_DIR "${OUTPUT_DIR}/compressed")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
 # Procesar cada archivo
+set(ENTRY_COUNT 0)
+set(TABLE_ENTRIES "")
 foreach(RESOURCE_FILE ${VALID_FILES})
-    # Leer contenido
-    file(READ "${RESOURCE_FILE}" FILE_CONTENT)
-    
     # Obtener nombre de variable y ruta relativa
     path_to_varname("${RESOURCE_FILE}" VAR_NAME)
+    path_to_webpath("${RESOURCE_FILE}" WEB_PATH)
     string(REPLACE "${SOURCE_DIR}/" "" REL_PATH "${RESOURCE_FILE}")
-    
-    # Obtener tipo MIME
-    get_mime_type("${RESOURCE_FILE}" MIME_TYPE)
-    
-    message(STATUS "  → ${REL_PATH} -> ${VAR_NAME}")
-    
+    set(FILE_CONTENT "${CONTENT_${WEB_PATH}}")
+    set(HASH "${HASH_${WEB_PATH}}")
+
+    # Las herramientas comprimen el contenido ya reescrito
+    set(WORK_FILE "${WORK_DIR}/${VAR_NAME}")
+    file(WRITE "${WORK_FILE}" "${FILE_CONTENT}")
+    file(SIZE "${WORK_FILE}" ORIGINAL_SIZE)
+    compress_resource("${GZIP}" "${WORK_FILE}" ${ORIGINAL_SIZE} GZIP_BYTES GZIP_SIZE -9 -n -c)
+    compress_resource("${BROTLI}" "${WORK_FILE}" ${ORIGINAL_SIZE} BROTLI_BYTES BROTLI_SIZE -q 11 -c)
+
+    message(STATUS "  → ${REL_PATH} -> ${VAR_NAME} (${ORIGINAL_SIZE} B, gzip ${GZIP_SIZE} B, brotli ${BROTLI_SIZE} B, huella ${HASH})")
+
     # Escribir constante con raw string
-    file(APPEND "${OUTPUT_FILE}" 
+    file(APPEND "${OUTPUT_FILE}"
 "// ${REL_PATH}
-const char* ${VAR_NAME} = R\"EMBED_RESOURCE(${FILE_CONTENT})EMBED_RESOURCE\";
-
+inline constexpr char ${VAR_NAME}[] = R\"EMBED_RESOURCE(${FILE_CONTENT})EMBED_RESOURCE\";
 ")
-endforeach()
+    if(GZIP_SIZE GREATER 0)
+        file(APPEND "${OUTPUT_FILE}" "inline constexpr unsigned char ${VAR_NAME}_GZIP[] = {${GZIP_BYTES}};\n")
+    endif()
+    if(BROTLI_SIZE GREATER 0)
+        file(APPEND "${OUTPUT_FILE}" "inline constexpr unsigned char ${VAR_NAME}_BROTLI[] = {${BROTLI_BYTES}};\n")
+    endif()
+
+    get_mime_type("${RESOURCE_FILE}" MIME_TYPE)
+    if(GZIP_SIZE GREATER 0)
+        set(GZIP_ENTRY "{${VAR_NAME}_GZIP, ${GZIP_SIZE}, \"\\\"${HASH}-gz\\\"\"}")
+    else()
+        set(GZIP_ENTRY "{nullptr, 0, {}}")
+    endif()
+    if(BROTLI_SIZE GREATER 0)
+        set(BROTLI_ENTRY "{${VAR_NAME}_BROTLI, ${BROTLI_SIZE}, \"\\\"${HASH}-br\\\"\"}")
+    else()
+        set(BROTLI_ENTRY "{nullptr, 0, {}}")
+    endif()
+    # Largo con sizeof: nada de strlen al servir
+    file(APPEND "${OUTPUT_FILE}"
+"inline constexpr Resource ${VAR_NAME}_RESOURCE = {
+    {${VAR_NAME}, sizeof(${VAR_NAME}) - 1}, \"${MIME_TYPE}\", \"\\\"${HASH}\\\"\", \"${HASHED_PATH_${WEB_PATH}}\",
+    ${GZIP_ENTRY},
+    ${BROTLI_ENTRY}
+};
 
-# Crear mapa de recursos
-file(APPEND "${OUTPUT_FILE}" 
-"// Mapa de recursos: ruta -> {contenido, mime_type}
-const std::unordered_map<std::string, Resource> RESOURCE_MAP = {
 ")
 
-set(FIRST_ENTRY TRUE)
-foreach(RESOURCE_FILE ${VALID_FILES})
-    path_to_varname("${RESOURCE_FILE}" VAR_NAME)
-    string(REPLACE "${SOURCE_DIR}/src/view/" "" WEB_PATH "${RESOURCE_FILE}")
-    string(REPLACE "${SOURCE_DIR}/src/view" "" WEB_PATH "${WEB_PATH}")
-    
-    # Normalizar la ruta web
-    if(NOT WEB_PATH MATCHES "^/")
-        set(WEB_PATH "/${WEB_PATH}")
+    # Entradas de la tabla, bajo la ruta normal y bajo la ruta con huella (sin la '/')
+    message(STATUS "  📍 Ruta web: ${WEB_PATH} -> ${VAR_NAME}")
+    string(SUBSTRING "${WEB_PATH}" 1 -1 KEY)
+    if(TABLE_ENTRIES)
+        string(APPEND TABLE_ENTRIES ",\n")
     endif()
-    
-    get_mime_type("${RESOURCE_FILE}" MIME_TYPE)
-    
-    if(NOT FIRST_ENTRY)
-        file(APPEND "${OUTPUT_FILE}" ",\n")
+    string(APPEND TABLE_ENTRIES "    Entry{\"${KEY}\", &${VAR_NAME}_RESOURCE, false}")
+    math(EXPR ENTRY_COUNT "${ENTRY_COUNT} + 1")
+    if(HASHED_PATH_${WEB_PATH})
+        message(STATUS "  📍 Ruta web: ${HASHED_PATH_${WEB_PATH}} -> ${VAR_NAME}")
+        string(SUBSTRING "${HASHED_PATH_${WEB_PATH}}" 1 -1 KEY)
+        string(APPEND TABLE_ENTRIES ",\n    Entry{\"${KEY}\", &${VAR_NAME}_RESOURCE, true}")
+        math(EXPR ENTRY_COUNT "${ENTRY_COUNT} + 1")
     endif()
-    set(FIRST_ENTRY FALSE)
-    
-    message(STATUS "  📍 Ruta web: ${WEB_PATH} -> ${VAR_NAME}")
-    file(APPEND "${OUTPUT_FILE}" "    {\"${WEB_PATH}\", {${VAR_NAME}, \"${MIME_TYPE}\"}}")
 endforeach()
 
-file(APPEND "${OUTPUT_FILE}" 
-"
-};
+# Tabla de rutas: hash perfecto calculado por el compilador
+file(APPEND "${OUTPUT_FILE}"
+"// Recursos distintos (la tabla tiene además las rutas con huella)
+constexpr size_t RESOURCE_COUNT = ${FILE_COUNT};
 
-// Función helper para obtener recursos
-inline const Resource* getResource(const std::string& path) {
-    auto it = RESOURCE_MAP.find(path);
-    if (it != RESOURCE_MAP.end()) {
-        return &it->second;
-    }
-    return nullptr;
+inline constexpr PerfectHashTable<${ENTRY_COUNT}> RESOURCE_TABLE{std::array<Entry, ${ENTRY_COUNT}>{
+${TABLE_ENTRIES}
+}};
+
+// Búsqueda por ruta, con o sin '/' inicial; no reserva memoria
+inline const Entry* findResource(std::string_view path) {
+    return RESOURCE_TABLE.find(path);
+}
+
+inline const Resource* getResource(std::string_view path) {
+    const Entry* entry = findResource(path);
+    return entry ? entry->resource : nullptr;
 }
 
 } // namespace Resources
@@ -155,4 +298,4 @@ inline const Resource* getResource(const std::string& path) {
 #endif // EMBEDDED_RESOURCES_H
 ")
 
-message(STATUS "✅ resources.h generado con ${FILE_COUNT} recursos")
\ No newline at end of file
+message(STATUS "✅ resources.h generado con ${FILE_COUNT} recursos")
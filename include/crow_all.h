@@ -2566,6 +2566,24 @@ namespace crow
         return empty;
     }
 
+    /// Receives the body of a request incrementally instead of buffering it in `request::body`.
+
+    ///
+    /// Installed by the app's body sink factory once the request headers are known.
+    struct body_sink
+    {
+        virtual ~body_sink() {}
+
+        /// Called for every piece of body data as soon as it is read from the socket.
+        virtual void feed(const char* data, size_t length) = 0;
+
+        /// Backpressure: asked before reading more of the body (`complete` false) and before running the handler (`complete` true).
+
+        ///
+        /// Returning false holds the connection (no reads, no timeout) until the sink calls `resume` exactly once, from any thread.
+        virtual bool ready(bool /*complete*/, std::function<void()> /*resume*/) { return true; }
+    };
+
     /// An HTTP request.
     struct request
     {
@@ -2575,6 +2593,7 @@ namespace crow
         query_string url_params; ///< The parameters associated with the request. (everything after the `?`)
         ci_map headers;
         std::string body;
+        std::shared_ptr<body_sink> sink; ///< Set when the body was streamed to a sink (`body` stays empty).
         std::string remote_ip_address; ///< The IP address from which the request was sent.
         unsigned char http_ver_major, http_ver_minor;
         bool keep_alive, close_connection, upgrade;
@@ -3015,6 +3034,10 @@ namespace crow
             headers = std::move(r.headers);
             completed_ = r.completed_;
             file_info = std::move(r.file_info);
+            body_writer_ = std::move(r.body_writer_);
+            static_body_ = r.static_body_;
+            r.static_body_ = {};
+            manual_length_header = r.manual_length_header;
             return *this;
         }
 
@@ -3031,6 +3054,10 @@ namespace crow
             headers.clear();
             completed_ = false;
             file_info = static_file_info{};
+            body_writer_ = nullptr;
+            static_body_ = {};
+            skip_body = false;
+            manual_length_header = false;
         }
 
         /// Return a "Temporary Redirect" response.
@@ -3086,8 +3113,13 @@ namespace crow
                 completed_ = true;
                 if (skip_body)
                 {
-                    set_header("Content-Length", std::to_string(body.size()));
+                    // An async body already carries its real Content-Length
+                    if (body_writer_)
+                        body_writer_ = nullptr;
+                    else
+                        set_header("Content-Length", std::to_string(body_size()));
                     body = "";
+                    static_body_ = {};
                     manual_length_header = true;
                 }
                 if (complete_request_handler_)
@@ -3170,11 +3202,61 @@ namespace crow
             }
         }
 
+        /// Writes the body straight to the socket once the headers are sent (e.g. with `sendfile`).
+
+        ///
+        /// The writer runs on the connection's io_service and must call `done(ok)` exactly once, from that same io_service.
+        /// The connection is neither read from nor timed out until then. Only plain TCP connections support it.
+        using async_body_writer = std::function<void(boost::asio::ip::tcp::socket&, std::function<void(bool)>)>;
+
+        /// Set an \ref async_body_writer as the response body (the Content-Length header must be set by the caller)
+        void set_async_body_writer(async_body_writer writer)
+        {
+            body_writer_ = std::move(writer);
+#ifdef CROW_ENABLE_COMPRESSION
+            compressed = false;
+#endif
+        }
+
+        /// Check whether the body is produced by an \ref async_body_writer.
+        bool is_async_body_type()
+        {
+            return static_cast<bool>(body_writer_);
+        }
+
+        /// Send `size` bytes at `data` as the body without copying them into \ref body.
+
+        ///
+        /// The memory is only referenced, so it must outlive the response (e.g. constants embedded in the binary).
+        /// It is written together with the headers in a single gather write.
+        void set_static_body(const char* data, size_t size)
+        {
+            body.clear();
+            static_body_ = boost::asio::const_buffer(data, size);
+#ifdef CROW_ENABLE_COMPRESSION
+            compressed = false;
+#endif
+        }
+
+        /// Check whether the body references memory set with \ref set_static_body.
+        bool is_static_body_type() const
+        {
+            return static_body_.size() > 0;
+        }
+
+        /// Size of the body that will be sent, wherever it lives.
+        size_t body_size() const
+        {
+            return is_static_body_type() ? static_body_.size() : body.size();
+        }
+
     private:
         bool completed_{};
         std::function<void()> complete_request_handler_;
         std::function<bool()> is_alive_helper_;
         static_file_info file_info;
+        async_body_writer body_writer_;
+        boost::asio::const_buffer static_body_;
     };
 } // namespace crow
 
@@ -3694,8 +3776,14 @@ namespace crow
 
 
 #pragma once
+#include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/array.hpp>
+#include <deque>
+#include <mutex>
+#ifdef CROW_ENABLE_COMPRESSION
+#include <zlib.h>
+#endif
 
 
 
@@ -3716,6 +3804,299 @@ namespace crow
             Payload,
         };
 
+        /// A complete, immutable websocket frame (header + payload).
+
+        ///
+        /// Built once and queued on any number of connections without copying.
+        using shared_frame = std::shared_ptr<const std::string>;
+
+        /// Header of an unmasked, unfragmented frame (server to client).
+
+        ///
+        /// compressed sets RSV1, which marks a permessage-deflate payload.
+        inline std::string frame_header(int opcode, size_t size, bool compressed = false)
+        {
+            char buf[2 + 8] = "\x80\x00";
+            buf[0] += opcode;
+            if (compressed)
+                buf[0] += 0x40;
+            if (size < 126)
+            {
+                buf[1] += static_cast<char>(size);
+                return {buf, buf + 2};
+            }
+            else if (size < 0x10000)
+            {
+                buf[1] += 126;
+                *(uint16_t*)(buf + 2) = htons(static_cast<uint16_t>(size));
+                return {buf, buf + 4};
+            }
+            else
+            {
+                buf[1] += 127;
+                *reinterpret_cast<uint64_t*>(buf + 2) = ((1 == htonl(1)) ? static_cast<uint64_t>(size) : (static_cast<uint64_t>(htonl((size)&0xFFFFFFFF)) << 32) | htonl(static_cast<uint64_t>(size) >> 32));
+                return {buf, buf + 10};
+            }
+        }
+
+        /// Frame a payload once for fan-out with connection::send_frame.
+        inline shared_frame make_frame(int opcode, const std::string& payload, bool compressed = false)
+        {
+            std::string frame = frame_header(opcode, payload.size(), compressed);
+            frame.reserve(frame.size() + payload.size());
+            frame += payload;
+            return std::make_shared<const std::string>(std::move(frame));
+        }
+
+#ifdef CROW_ENABLE_COMPRESSION
+        /// Raw DEFLATE as permessage-deflate uses it (RFC 7692 section 7.2.1).
+
+        ///
+        /// Every message ends with a sync flush whose 00 00 ff ff tail is left out.
+        class message_deflater
+        {
+        public:
+            message_deflater(int level, int window_bits)
+            {
+                ok_ = ::deflateInit2(&stream_, level, Z_DEFLATED, -window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+            ~message_deflater()
+            {
+                if (ok_)
+                    ::deflateEnd(&stream_);
+            }
+            message_deflater(const message_deflater&) = delete;
+            message_deflater& operator=(const message_deflater&) = delete;
+
+            /// reset forgets the history afterwards (no context takeover).
+            bool compress(const std::string& in, std::string& out, bool reset)
+            {
+                if (!ok_)
+                    return false;
+
+                // zlib does not take a const pointer. The data is not altered.
+                stream_.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(in.data()));
+                stream_.avail_in = in.size();
+
+                out.resize(::deflateBound(&stream_, in.size()) + 16);
+                size_t used = 0;
+                while (true)
+                {
+                    stream_.next_out = reinterpret_cast<Bytef*>(&out[used]);
+                    stream_.avail_out = out.size() - used;
+                    int code = ::deflate(&stream_, Z_SYNC_FLUSH);
+                    used = out.size() - stream_.avail_out;
+                    if (code != Z_OK && code != Z_BUF_ERROR)
+                    {
+                        ::deflateReset(&stream_);
+                        return false;
+                    }
+                    // Room left over means the flush is complete
+                    if (stream_.avail_out != 0)
+                        break;
+                    out.resize(out.size() * 2);
+                }
+
+                if (used >= 4 && out.compare(used - 4, 4, "\x00\x00\xff\xff", 4) == 0)
+                    used -= 4;
+                out.resize(used);
+                if (reset)
+                    ::deflateReset(&stream_);
+                return true;
+            }
+
+        private:
+            z_stream stream_{};
+            bool ok_{false};
+        };
+
+        /// Counterpart of message_deflater for client messages.
+        class message_inflater
+        {
+        public:
+            message_inflater()
+            {
+                // A 15-bit window decodes streams made with any smaller one
+                ok_ = ::inflateInit2(&stream_, -15) == Z_OK;
+            }
+            ~message_inflater()
+            {
+                if (ok_)
+                    ::inflateEnd(&stream_);
+            }
+            message_inflater(const message_inflater&) = delete;
+            message_inflater& operator=(const message_inflater&) = delete;
+
+            /// Fails on corrupt data or if the message inflates past max_size.
+            bool decompress(std::string& in, std::string& out, size_t max_size, bool reset)
+            {
+                if (!ok_)
+                    return false;
+
+                in.append("\x00\x00\xff\xff", 4);
+                stream_.next_in = reinterpret_cast<Bytef*>(&in[0]);
+                stream_.avail_in = in.size();
+
+                char buffer[16384];
+                bool ok = true;
+                while (true)
+                {
+                    stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+                    stream_.avail_out = sizeof(buffer);
+                    int code = ::inflate(&stream_, Z_SYNC_FLUSH);
+                    if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR)
+                    {
+                        ok = false;
+                        break;
+                    }
+                    out.append(buffer, sizeof(buffer) - stream_.avail_out);
+                    if (out.size() > max_size)
+                    {
+                        ok = false;
+                        break;
+                    }
+                    // A final block ends the stream; what follows is our own tail
+                    if (code == Z_STREAM_END)
+                    {
+                        reset = true;
+                        break;
+                    }
+                    if (stream_.avail_out != 0 && (stream_.avail_in == 0 || code == Z_BUF_ERROR))
+                        break;
+                }
+
+                if (reset || !ok)
+                    ::inflateReset(&stream_);
+                return ok;
+            }
+
+        private:
+            z_stream stream_{};
+            bool ok_{false};
+        };
+
+        /// Compressor for messages sent without context takeover, shared by every connection on this thread.
+        inline message_deflater& thread_deflater(int level)
+        {
+            static thread_local std::unique_ptr<message_deflater> deflater;
+            static thread_local int deflater_level;
+            if (!deflater || deflater_level != level)
+            {
+                deflater.reset(new message_deflater(level, 15));
+                deflater_level = level;
+            }
+            return *deflater;
+        }
+#endif
+
+        /// A message fanned out to many connections with connection::send_message.
+
+        ///
+        /// Each connection sends the framing it negotiated. The plain frame and the
+        /// frame compressed without context takeover are each built at most once,
+        /// by whichever connection needs them first.
+        class shared_message
+        {
+        public:
+            shared_message(int opcode, std::string payload):
+              opcode_(opcode), payload_(std::move(payload))
+            {}
+
+            int opcode() const { return opcode_; }
+            const std::string& payload() const { return payload_; }
+
+            shared_frame plain() const
+            {
+                std::call_once(plain_once_, [this] {
+                    plain_ = make_frame(opcode_, payload_);
+                });
+                return plain_;
+            }
+
+#ifdef CROW_ENABLE_COMPRESSION
+            /// Compressed with a fresh 15-bit window; level only matters on the first call.
+            shared_frame deflated(int level) const
+            {
+                std::call_once(deflated_once_, [this, level] {
+                    std::string compressed;
+                    // Not worth it if it does not shrink: the plain frame is just as valid
+                    if (thread_deflater(level).compress(payload_, compressed, true) && compressed.size() < payload_.size())
+                        deflated_ = make_frame(opcode_, compressed, true);
+                    else
+                        deflated_ = plain();
+                });
+                return deflated_;
+            }
+#endif
+
+        private:
+            int opcode_;
+            std::string payload_;
+            mutable std::once_flag plain_once_;
+            mutable shared_frame plain_;
+#ifdef CROW_ENABLE_COMPRESSION
+            mutable std::once_flag deflated_once_;
+            mutable shared_frame deflated_;
+#endif
+        };
+
+        using shared_message_ptr = std::shared_ptr<const shared_message>;
+
+        /// What send_frame does when a connection is over its send_budget.
+        enum class overflow_policy
+        {
+            disconnect,  ///< Drop the connection.
+            drop_oldest, ///< Discard the oldest queued send_frame frames until the new one fits.
+            resync,      ///< Discard every queued send_frame frame, send send_budget::resync_frame once and
+                         ///< skip further frames until it has been written.
+        };
+
+        /// Reported by send_budget::on_overflow.
+        struct overflow_event
+        {
+            overflow_policy policy;
+            size_t dropped;     ///< frames discarded, including the one being sent
+            bool resync_queued; ///< the resync frame was queued
+            bool disconnected;
+        };
+
+        /// Limits for frames queued with send_frame; frames still waiting to be
+        /// written or in flight count against it, other sends do not.
+        struct send_budget
+        {
+            size_t max_bytes{0};  ///< 0 = unlimited
+            size_t max_frames{0}; ///< 0 = unlimited
+            overflow_policy policy{overflow_policy::disconnect};
+            shared_frame resync_frame;
+            /// Called on the connection's thread whenever frames are discarded or the client is dropped.
+            std::function<void(const overflow_event&)> on_overflow;
+        };
+
+        /// permessage-deflate (RFC 7692) settings; needs CROW_ENABLE_COMPRESSION.
+        struct deflate_options
+        {
+            bool enabled{false};
+            /// Messages smaller than this many bytes are sent uncompressed.
+            size_t threshold{512};
+            /// Compress each message on its own. Small messages shrink less, but the
+            /// connection keeps no compressor of its own and a shared_message is
+            /// compressed once for all its connections.
+            bool server_no_context_takeover{true};
+            /// Ask clients to do the same.
+            bool client_no_context_takeover{false};
+            int level{6}; ///< zlib level, 1 (fastest) to 9 (smallest)
+            /// Client messages that inflate past this close the connection.
+            size_t max_inflated_size{64 * 1024 * 1024};
+        };
+
+        /// Handshake settings shared by every connection of a websocket rule.
+        struct connection_options
+        {
+            /// Subprotocols the server speaks, in order of preference.
+            std::vector<std::string> subprotocols;
+            deflate_options deflate;
+        };
+
         /// A base class for websocket connection.
         struct connection
         {
@@ -3730,6 +4111,36 @@ namespace crow
             void userdata(void* u) { userdata_ = u; }
             void* userdata() { return userdata_; }
 
+            /// Queue a prebuilt frame (see make_frame). Safe to call from any thread.
+
+            ///
+            /// Frames over the connection's send_budget are handled by its overflow_policy.
+            virtual void send_frame(shared_frame frame) = 0;
+
+            /// Queue a message in the framing this connection negotiated (see shared_message).
+
+            ///
+            /// Safe to call from any thread; counts against the send_budget like send_frame.
+            virtual void send_message(shared_message_ptr message) = 0;
+
+            /// Set before sending any frame (e.g. in the open handler).
+            void set_send_budget(send_budget budget) { budget_ = std::move(budget); }
+
+            /// Query string of the upgrade request (e.g. "/ws?since=42").
+            const query_string& url_params() const { return url_params_; }
+
+            /// Subprotocol agreed in the handshake (Sec-WebSocket-Protocol), empty if none.
+            const std::string& subprotocol() const { return subprotocol_; }
+
+            /// permessage-deflate was agreed in the handshake.
+            bool compressed() const { return compressed_; }
+
+        protected:
+            query_string url_params_;
+            std::string subprotocol_;
+            bool compressed_{false};
+            send_budget budget_;
+
         private:
             void* userdata_;
         };
@@ -3772,7 +4183,8 @@ namespace crow
                        std::function<void(crow::websocket::connection&, const std::string&, bool)> message_handler,
                        std::function<void(crow::websocket::connection&, const std::string&)> close_handler,
                        std::function<void(crow::websocket::connection&)> error_handler,
-                       std::function<bool(const crow::request&)> accept_handler):
+                       std::function<bool(const crow::request&)> accept_handler,
+                       const connection_options& options = {}):
               adaptor_(std::move(adaptor)),
               open_handler_(std::move(open_handler)), message_handler_(std::move(message_handler)), close_handler_(std::move(close_handler)), error_handler_(std::move(error_handler)), accept_handler_(std::move(accept_handler))
             {
@@ -3783,6 +4195,17 @@ namespace crow
                     return;
                 }
 
+                url_params_ = req.url_params;
+                subprotocol_ = select_subprotocol(req.get_header_value("Sec-WebSocket-Protocol"), options.subprotocols);
+#ifdef CROW_ENABLE_COMPRESSION
+                if (options.deflate.enabled)
+                {
+                    deflate_options_ = options.deflate;
+                    extensions_ = negotiate_deflate(req.get_header_value("Sec-WebSocket-Extensions"));
+                    compressed_ = !extensions_.empty();
+                }
+#endif
+
                 if (accept_handler_)
                 {
                     if (!accept_handler_(req))
@@ -3824,9 +4247,8 @@ namespace crow
             void send_ping(const std::string& msg) override
             {
                 dispatch([this, msg] {
-                    auto header = build_header(0x9, msg.size());
-                    write_buffers_.emplace_back(std::move(header));
-                    write_buffers_.emplace_back(msg);
+                    queue_buffer(build_header(0x9, msg.size()));
+                    queue_buffer(msg);
                     do_write();
                 });
             }
@@ -3838,9 +4260,8 @@ namespace crow
             void send_pong(const std::string& msg) override
             {
                 dispatch([this, msg] {
-                    auto header = build_header(0xA, msg.size());
-                    write_buffers_.emplace_back(std::move(header));
-                    write_buffers_.emplace_back(msg);
+                    queue_buffer(build_header(0xA, msg.size()));
+                    queue_buffer(msg);
                     do_write();
                 });
             }
@@ -3849,9 +4270,7 @@ namespace crow
             void send_binary(const std::string& msg) override
             {
                 dispatch([this, msg] {
-                    auto header = build_header(2, msg.size());
-                    write_buffers_.emplace_back(std::move(header));
-                    write_buffers_.emplace_back(msg);
+                    queue_message(2, msg);
                     do_write();
                 });
             }
@@ -3860,13 +4279,48 @@ namespace crow
             void send_text(const std::string& msg) override
             {
                 dispatch([this, msg] {
-                    auto header = build_header(1, msg.size());
-                    write_buffers_.emplace_back(std::move(header));
-                    write_buffers_.emplace_back(msg);
+                    queue_message(1, msg);
                     do_write();
                 });
             }
 
+            /// Queue a shared frame, applying the send_budget.
+            void send_frame(shared_frame frame) override
+            {
+                std::weak_ptr<void> alive = alive_;
+                dispatch([this, alive, frame] {
+                    // The connection may have been destroyed while this was queued
+                    if (alive.expired() || close_connection_)
+                        return;
+                    queue_budgeted({frame, frame_kind::budgeted, frame->size(), nullptr});
+                });
+            }
+
+            /// Queue a shared message, applying the send_budget.
+            void send_message(shared_message_ptr message) override
+            {
+                std::weak_ptr<void> alive = alive_;
+                dispatch([this, alive, message] {
+                    if (alive.expired() || close_connection_)
+                        return;
+#ifdef CROW_ENABLE_COMPRESSION
+                    if (deflates(message->payload().size()))
+                    {
+                        if (!reset_deflater_)
+                        {
+                            queue_budgeted({nullptr, frame_kind::budgeted, message->payload().size(), message});
+                            return;
+                        }
+                        auto frame = server_window_bits_ == 15 ? message->deflated(deflate_options_.level) : deflate_frame(*message);
+                        queue_budgeted({frame, frame_kind::budgeted, frame->size(), nullptr});
+                        return;
+                    }
+#endif
+                    auto frame = message->plain();
+                    queue_budgeted({frame, frame_kind::budgeted, frame->size(), nullptr});
+                });
+            }
+
             /// Send a close signal.
 
             ///
@@ -3881,9 +4335,8 @@ namespace crow
                         if (close_handler_)
                             close_handler_(*this, msg);
                     }
-                    auto header = build_header(0x8, msg.size());
-                    write_buffers_.emplace_back(std::move(header));
-                    write_buffers_.emplace_back(msg);
+                    queue_buffer(build_header(0x8, msg.size()));
+                    queue_buffer(msg);
                     do_write();
                 });
             }
@@ -3897,25 +4350,236 @@ namespace crow
             /// Generate the websocket headers using an opcode and the message size (in bytes).
             std::string build_header(int opcode, size_t size)
             {
-                char buf[2 + 8] = "\x80\x00";
-                buf[0] += opcode;
-                if (size < 126)
+                return frame_header(opcode, size);
+            }
+
+            /// First of the server's subprotocols that the client offered.
+            static std::string select_subprotocol(const std::string& offered, const std::vector<std::string>& supported)
+            {
+                std::vector<std::string> tokens;
+                boost::split(tokens, offered, boost::is_any_of(","));
+                for (auto& token : tokens)
+                    boost::trim(token);
+
+                for (const auto& protocol : supported)
+                    if (std::find(tokens.begin(), tokens.end(), protocol) != tokens.end())
+                        return protocol;
+                return {};
+            }
+
+            enum class frame_kind : char
+            {
+                regular,
+                budgeted, ///< queued by send_frame, counted in the send_budget
+                resync,
+            };
+
+            struct queued_buffer
+            {
+                shared_frame data;
+                frame_kind kind;
+                size_t charged; ///< bytes counted in the send_budget
+                /// Compressed with context takeover when handed to the socket: a
+                /// message discarded before that must not enter the deflater's history.
+                shared_message_ptr deferred;
+            };
+
+            void queue_buffer(std::string buffer)
+            {
+                write_buffers_.push_back({std::make_shared<const std::string>(std::move(buffer)), frame_kind::regular, 0, nullptr});
+            }
+
+            /// Queue a data message, compressed if permessage-deflate applies.
+            void queue_message(int opcode, const std::string& msg)
+            {
+#ifdef CROW_ENABLE_COMPRESSION
+                if (deflates(msg.size()))
                 {
-                    buf[1] += static_cast<char>(size);
-                    return {buf, buf + 2};
+                    auto message = std::make_shared<const shared_message>(opcode, msg);
+                    if (reset_deflater_)
+                        write_buffers_.push_back({deflate_frame(*message), frame_kind::regular, 0, nullptr});
+                    else
+                        write_buffers_.push_back({nullptr, frame_kind::regular, 0, std::move(message)});
+                    return;
                 }
-                else if (size < 0x10000)
+#endif
+                queue_buffer(build_header(opcode, msg.size()));
+                queue_buffer(msg);
+            }
+
+            void queue_budgeted(queued_buffer buffer)
+            {
+                if (resync_pending_)
                 {
-                    buf[1] += 126;
-                    *(uint16_t*)(buf + 2) = htons(static_cast<uint16_t>(size));
-                    return {buf, buf + 4};
+                    // The client will fetch it after the resync notice
+                    if (budget_.on_overflow)
+                        budget_.on_overflow({budget_.policy, 1, false, false});
+                    return;
                 }
+                if (!fits_budget(buffer.charged) && !make_room(buffer.charged))
+                    return;
+                budget_bytes_ += buffer.charged;
+                budget_frames_++;
+                write_buffers_.push_back(std::move(buffer));
+                do_write();
+            }
+
+#ifdef CROW_ENABLE_COMPRESSION
+            bool deflates(size_t size) const
+            {
+                return compressed_ && size >= deflate_options_.threshold;
+            }
+
+            /// Compress with this connection's settings, sharing the thread's compressor when possible.
+            shared_frame deflate_frame(const shared_message& message)
+            {
+                message_deflater* deflater;
+                if (reset_deflater_ && server_window_bits_ == 15)
+                    deflater = &thread_deflater(deflate_options_.level);
                 else
                 {
-                    buf[1] += 127;
-                    *reinterpret_cast<uint64_t*>(buf + 2) = ((1 == htonl(1)) ? static_cast<uint64_t>(size) : (static_cast<uint64_t>(htonl((size)&0xFFFFFFFF)) << 32) | htonl(static_cast<uint64_t>(size) >> 32));
-                    return {buf, buf + 10};
+                    if (!deflater_)
+                        deflater_.reset(new message_deflater(deflate_options_.level, server_window_bits_));
+                    deflater = deflater_.get();
+                }
+
+                std::string compressed;
+                if (!deflater->compress(message.payload(), compressed, reset_deflater_))
+                {
+                    CROW_LOG_WARNING << "websocket: deflate failed, sending uncompressed";
+                    return message.plain();
+                }
+                if (reset_deflater_ && compressed.size() >= message.payload().size())
+                    return message.plain();
+                return make_frame(message.opcode(), compressed, true);
+            }
+
+            /// Accept the first permessage-deflate offer we can honour; the Sec-WebSocket-Extensions
+            /// reply, or empty if there is none.
+            std::string negotiate_deflate(const std::string& offered)
+            {
+                std::vector<std::string> offers;
+                boost::split(offers, offered, boost::is_any_of(","));
+                for (const auto& offer : offers)
+                {
+                    std::vector<std::string> params;
+                    boost::split(params, offer, boost::is_any_of(";"));
+                    for (auto& param : params)
+                        boost::trim(param);
+                    if (params[0] != "permessage-deflate")
+                        continue;
+
+                    bool server_no_context_takeover = deflate_options_.server_no_context_takeover;
+                    bool client_no_context_takeover = deflate_options_.client_no_context_takeover;
+                    int server_window_bits = 15;
+                    bool valid = true;
+                    for (size_t i = 1; i < params.size() && valid; i++)
+                    {
+                        auto eq = params[i].find('=');
+                        std::string name = boost::trim_copy(params[i].substr(0, eq));
+                        std::string value = eq == std::string::npos ? "" : boost::trim_copy_if(params[i].substr(eq + 1), boost::is_any_of(" \t\""));
+                        if (name == "server_no_context_takeover")
+                            server_no_context_takeover = true;
+                        else if (name == "client_no_context_takeover")
+                            client_no_context_takeover = true;
+                        else if (name == "server_max_window_bits")
+                        {
+                            // zlib cannot produce raw deflate with an 8-bit window
+                            int bits = std::atoi(value.c_str());
+                            valid = bits >= 9 && bits <= 15;
+                            server_window_bits = bits;
+                        }
+                        else if (name != "client_max_window_bits") // our inflater accepts any window
+                            valid = false;
+                    }
+                    if (!valid)
+                        continue;
+
+                    reset_deflater_ = server_no_context_takeover;
+                    reset_inflater_ = client_no_context_takeover;
+                    server_window_bits_ = server_window_bits;
+
+                    std::string reply = "permessage-deflate";
+                    if (server_no_context_takeover)
+                        reply += "; server_no_context_takeover";
+                    if (client_no_context_takeover)
+                        reply += "; client_no_context_takeover";
+                    if (server_window_bits < 15)
+                        reply += "; server_max_window_bits=" + std::to_string(server_window_bits);
+                    return reply;
+                }
+                return {};
+            }
+#endif
+
+            bool fits_budget(size_t size) const
+            {
+                return (!budget_.max_bytes || budget_bytes_ + size <= budget_.max_bytes) &&
+                       (!budget_.max_frames || budget_frames_ + 1 <= budget_.max_frames);
+            }
+
+            /// Apply the overflow policy; true if the new frame can now be queued.
+            bool make_room(size_t size)
+            {
+                overflow_event event{budget_.policy, 0, false, false};
+                bool queue_frame = false;
+
+                switch (budget_.policy)
+                {
+                    case overflow_policy::disconnect:
+                        CROW_LOG_WARNING << "websocket: send budget exceeded, dropping slow client";
+                        close_connection_ = true;
+                        adaptor_.shutdown_readwrite();
+                        event.dropped = 1;
+                        event.disconnected = true;
+                        break;
+
+                    case overflow_policy::drop_oldest:
+                        // Only frames not yet handed to the socket can be discarded
+                        for (auto it = write_buffers_.begin(); it != write_buffers_.end() && !fits_budget(size);)
+                        {
+                            if (it->kind != frame_kind::budgeted)
+                            {
+                                ++it;
+                                continue;
+                            }
+                            budget_bytes_ -= it->charged;
+                            budget_frames_--;
+                            event.dropped++;
+                            it = write_buffers_.erase(it);
+                        }
+                        queue_frame = fits_budget(size);
+                        if (!queue_frame)
+                            event.dropped++; // the new frame itself
+                        break;
+
+                    case overflow_policy::resync:
+                        for (auto it = write_buffers_.begin(); it != write_buffers_.end();)
+                        {
+                            if (it->kind != frame_kind::budgeted)
+                            {
+                                ++it;
+                                continue;
+                            }
+                            budget_bytes_ -= it->charged;
+                            budget_frames_--;
+                            event.dropped++;
+                            it = write_buffers_.erase(it);
+                        }
+                        event.dropped++; // the new frame
+                        if (budget_.resync_frame)
+                        {
+                            resync_pending_ = true;
+                            event.resync_queued = true;
+                            write_buffers_.push_back({budget_.resync_frame, frame_kind::resync, 0, nullptr});
+                            do_write();
+                        }
+                        break;
                 }
+
+                if (budget_.on_overflow)
+                    budget_.on_overflow(event);
+                return queue_frame;
             }
 
             /// Send the HTTP upgrade response.
@@ -3928,10 +4592,16 @@ namespace crow
                                             "Upgrade: websocket\r\n"
                                             "Connection: Upgrade\r\n"
                                             "Sec-WebSocket-Accept: ";
-                write_buffers_.emplace_back(header);
-                write_buffers_.emplace_back(std::move(hello));
-                write_buffers_.emplace_back(crlf);
-                write_buffers_.emplace_back(crlf);
+                queue_buffer(header);
+                queue_buffer(std::move(hello));
+                queue_buffer(crlf);
+                if (!subprotocol_.empty())
+                    queue_buffer("Sec-WebSocket-Protocol: " + subprotocol_ + crlf);
+#ifdef CROW_ENABLE_COMPRESSION
+                if (!extensions_.empty())
+                    queue_buffer("Sec-WebSocket-Extensions: " + extensions_ + crlf);
+#endif
+                queue_buffer(crlf);
                 do_write();
                 if (open_handler_)
                     open_handler_(*this);
@@ -4167,6 +4837,12 @@ namespace crow
                 return mini_header_ & 0x8000;
             }
 
+            /// Check if the RSV1 bit (permessage-deflate) is set; only meaningful on a message's first frame.
+            bool is_RSV1()
+            {
+                return mini_header_ & 0x4000;
+            }
+
             /// Extract the opcode from the header.
             int opcode()
             {
@@ -4192,35 +4868,25 @@ namespace crow
                     {
                         message_ += fragment_;
                         if (is_FIN())
-                        {
-                            if (message_handler_)
-                                message_handler_(*this, message_, is_binary_);
-                            message_.clear();
-                        }
+                            handle_message();
                     }
                     break;
                     case 1: // Text
                     {
                         is_binary_ = false;
+                        is_compressed_ = compressed_ && is_RSV1();
                         message_ += fragment_;
                         if (is_FIN())
-                        {
-                            if (message_handler_)
-                                message_handler_(*this, message_, is_binary_);
-                            message_.clear();
-                        }
+                            handle_message();
                     }
                     break;
                     case 2: // Binary
                     {
                         is_binary_ = true;
+                        is_compressed_ = compressed_ && is_RSV1();
                         message_ += fragment_;
                         if (is_FIN())
-                        {
-                            if (message_handler_)
-                                message_handler_(*this, message_, is_binary_);
-                            message_.clear();
-                        }
+                            handle_message();
                     }
                     break;
                     case 0x8: // Close
@@ -4259,6 +4925,30 @@ namespace crow
                 fragment_.clear();
             }
 
+            /// Pass a complete message to the message handler, inflating it if needed.
+            void handle_message()
+            {
+#ifdef CROW_ENABLE_COMPRESSION
+                if (is_compressed_)
+                {
+                    if (!inflater_)
+                        inflater_.reset(new message_inflater());
+                    std::string inflated;
+                    if (!inflater_->decompress(message_, inflated, deflate_options_.max_inflated_size, reset_inflater_))
+                    {
+                        CROW_LOG_WARNING << "websocket: invalid or oversized compressed message";
+                        message_.clear();
+                        close("invalid compressed message");
+                        return;
+                    }
+                    message_.swap(inflated);
+                }
+#endif
+                if (message_handler_)
+                    message_handler_(*this, message_, is_binary_);
+                message_.clear();
+            }
+
             /// Send the buffers' data through the socket.
 
             ///
@@ -4272,11 +4962,28 @@ namespace crow
                     buffers.reserve(sending_buffers_.size());
                     for (auto& s : sending_buffers_)
                     {
-                        buffers.emplace_back(boost::asio::buffer(s));
+#ifdef CROW_ENABLE_COMPRESSION
+                        if (s.deferred)
+                        {
+                            s.data = deflate_frame(*s.deferred);
+                            s.deferred.reset();
+                        }
+#endif
+                        buffers.emplace_back(boost::asio::buffer(*s.data));
                     }
                     boost::asio::async_write(
                       adaptor_.socket(), buffers,
                       [&](const boost::system::error_code& ec, std::size_t /*bytes_transferred*/) {
+                          for (auto& s : sending_buffers_)
+                          {
+                              if (s.kind == frame_kind::budgeted)
+                              {
+                                  budget_bytes_ -= s.charged;
+                                  budget_frames_--;
+                              }
+                              else if (s.kind == frame_kind::resync)
+                                  resync_pending_ = false;
+                          }
                           sending_buffers_.clear();
                           if (!ec && !close_connection_)
                           {
@@ -4299,8 +5006,12 @@ namespace crow
             {
                 //if (has_sent_close_ && has_recv_close_)
                 if (!is_close_handler_called_)
+                {
+                    // Both the read and the write path can get here: notify only once
+                    is_close_handler_called_ = true;
                     if (close_handler_)
                         close_handler_(*this, "uncleanly");
+                }
                 if (sending_buffers_.empty() && !is_reading)
                     delete this;
             }
@@ -4308,11 +5019,25 @@ namespace crow
         private:
             Adaptor adaptor_;
 
-            std::vector<std::string> sending_buffers_;
-            std::vector<std::string> write_buffers_;
+            std::deque<queued_buffer> sending_buffers_;
+            std::deque<queued_buffer> write_buffers_;
+            size_t budget_bytes_{0};
+            size_t budget_frames_{0};
+            bool resync_pending_{false};
+            std::shared_ptr<void> alive_{std::make_shared<char>(0)};
+#ifdef CROW_ENABLE_COMPRESSION
+            deflate_options deflate_options_;
+            std::string extensions_;
+            int server_window_bits_{15};
+            bool reset_deflater_{true};
+            bool reset_inflater_{false};
+            std::unique_ptr<message_deflater> deflater_; ///< only with context takeover or a smaller window
+            std::unique_ptr<message_inflater> inflater_;
+#endif
 
             boost::array<char, 4096> buffer_;
             bool is_binary_;
+            bool is_compressed_{false};
             std::string message_;
             std::string fragment_;
             WebSocketReadState state_{WebSocketReadState::MiniHeader};
@@ -6434,7 +7159,10 @@ namespace crow
         static int on_body(http_parser* self_, const char* at, size_t length)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
-            self->body.insert(self->body.end(), at, at + length);
+            if (self->sink)
+                self->sink->feed(at, length);
+            else
+                self->body.insert(self->body.end(), at, at + length);
             return 0;
         }
         static int on_message_complete(http_parser* self_)
@@ -6494,6 +7222,7 @@ namespace crow
             headers.clear();
             url_params.clear();
             body.clear();
+            sink.reset();
             header_building_state = 0;
             qs_point = 0;
             http_major = 0;
@@ -6532,7 +7261,9 @@ namespace crow
         /// Take the parsed HTTP request data and convert it to a \ref crow.request
         request to_request() const
         {
-            return request{static_cast<HTTPMethod>(method), std::move(raw_url), std::move(url), std::move(url_params), std::move(headers), std::move(body), http_major, http_minor, keep_alive, close_connection, static_cast<bool>(upgrade)};
+            request req{static_cast<HTTPMethod>(method), std::move(raw_url), std::move(url), std::move(url_params), std::move(headers), std::move(body), http_major, http_minor, keep_alive, close_connection, static_cast<bool>(upgrade)};
+            req.sink = sink;
+            return req;
         }
 
         std::string raw_url;
@@ -6545,6 +7276,7 @@ namespace crow
         ci_map headers;
         query_string url_params; ///< What comes after the `?` in the URL.
         std::string body;
+        std::shared_ptr<body_sink> sink; ///< Receives the body instead of `body` when the app asked to stream it.
         bool keep_alive;       ///< Whether or not the server should send a `connection: Keep-Alive` header to the client.
         bool close_connection; ///< Whether or not the server should shut down the TCP connection once a response is sent.
 
@@ -9658,12 +10390,12 @@ namespace crow
 
         void handle_upgrade(const request& req, response&, SocketAdaptor&& adaptor) override
         {
-            new crow::websocket::Connection<SocketAdaptor>(req, std::move(adaptor), open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_);
+            new crow::websocket::Connection<SocketAdaptor>(req, std::move(adaptor), open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_, options_);
         }
 #ifdef CROW_ENABLE_SSL
         void handle_upgrade(const request& req, response&, SSLAdaptor&& adaptor) override
         {
-            new crow::websocket::Connection<SSLAdaptor>(req, std::move(adaptor), open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_);
+            new crow::websocket::Connection<SSLAdaptor>(req, std::move(adaptor), open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_, options_);
         }
 #endif
 
@@ -9702,7 +10434,22 @@ namespace crow
             return *this;
         }
 
+        /// Subprotocols to negotiate, in order of preference; see connection::subprotocol().
+        self_t& subprotocols(std::vector<std::string> protocols)
+        {
+            options_.subprotocols = std::move(protocols);
+            return *this;
+        }
+
+        /// Offer permessage-deflate (needs CROW_ENABLE_COMPRESSION); see connection::compressed().
+        self_t& permessage_deflate(websocket::deflate_options options)
+        {
+            options_.deflate = std::move(options);
+            return *this;
+        }
+
     protected:
+        websocket::connection_options options_;
         std::function<void(crow::websocket::connection&)> open_handler_;
         std::function<void(crow::websocket::connection&, const std::string&, bool)> message_handler_;
         std::function<void(crow::websocket::connection&, const std::string&)> close_handler_;
@@ -11295,15 +12042,31 @@ namespace crow
             // HTTP 1.1 Expect: 100-continue
             if (parser_.http_major == 1 && parser_.http_minor == 1 && get_header_value(parser_.headers, "expect") == "100-continue") // Using the parser because the request isn't made yet.
             {
-                buffers_.clear();
                 static std::string expect_100_continue = "HTTP/1.1 100 Continue\r\n\r\n";
-                buffers_.emplace_back(expect_100_continue.data(), expect_100_continue.size());
-                do_write();
+                // Not do_write(): its completion clears the parser, which is still in the middle of this request
+                is_writing = true;
+                boost::asio::async_write(
+                  adaptor_.socket(), boost::asio::buffer(expect_100_continue),
+                  [this](const boost::system::error_code& ec, std::size_t /*bytes_transferred*/) {
+                      is_writing = false;
+                      if (ec)
+                      {
+                          adaptor_.close();
+                          CROW_LOG_DEBUG << this << " from write (100-continue)";
+                          check_destroy();
+                      }
+                  });
             }
+
+            parser_.sink = handler_->make_body_sink(static_cast<HTTPMethod>(parser_.method), parser_.raw_url, parser_.headers);
         }
 
         void handle()
         {
+            // The sink may still be writing the body: the handler runs once it is done
+            if (wait_for_sink(true))
+                return;
+
             cancel_deadline_timer();
             bool is_invalid_request = false;
             add_keep_alive_ = false;
@@ -11443,6 +12206,10 @@ namespace crow
             {
                 do_write_static();
             }
+            else if (res.is_async_body_type())
+            {
+                do_write_async_body();
+            }
             else
             {
                 do_write_general();
@@ -11519,7 +12286,7 @@ namespace crow
                 buffers_.emplace_back(status.data(), status.size());
             }
 
-            if (res.code >= 400 && res.body.empty())
+            if (res.code >= 400 && res.body_size() == 0)
                 res.body = statusCodes[res.code].substr(9);
 
             for (auto& kv : res.headers)
@@ -11532,7 +12299,7 @@ namespace crow
 
             if (!res.manual_length_header && !res.headers.count("content-length"))
             {
-                content_length_ = std::to_string(res.body.size());
+                content_length_ = std::to_string(res.body_size());
                 static std::string content_length_tag = "Content-Length: ";
                 buffers_.emplace_back(content_length_tag.data(), content_length_tag.size());
                 buffers_.emplace_back(content_length_.data(), content_length_.size());
@@ -11553,7 +12320,8 @@ namespace crow
                 buffers_.emplace_back(date_str_.data(), date_str_.size());
                 buffers_.emplace_back(crlf.data(), crlf.size());
             }
-            if (add_keep_alive_)
+            // A deferred handler already got "connection" from handle()
+            if (add_keep_alive_ && !res.headers.count("connection"))
             {
                 static std::string keep_alive_tag = "Connection: Keep-Alive";
                 buffers_.emplace_back(keep_alive_tag.data(), keep_alive_tag.size());
@@ -11596,9 +12364,84 @@ namespace crow
             parser_.clear();
         }
 
+        void do_write_async_body()
+        {
+            is_writing = true;
+            writing_async_body_ = true;
+            boost::asio::async_write(
+              adaptor_.socket(), buffers_,
+              [this](const boost::system::error_code& ec, std::size_t /*bytes_transferred*/) {
+                  if (ec)
+                  {
+                      finish_async_body(false);
+                      return;
+                  }
+                  start_body_writer(adaptor_);
+              });
+        }
+
+        void start_body_writer(SocketAdaptor& adaptor)
+        {
+            res.body_writer_(adaptor.raw_socket(), [this](bool ok) {
+                finish_async_body(ok);
+            });
+        }
+
+        template<typename OtherAdaptor>
+        void start_body_writer(OtherAdaptor&)
+        {
+            CROW_LOG_ERROR << "Async body writers require a plain TCP connection";
+            finish_async_body(false);
+        }
+
+        void finish_async_body(bool ok)
+        {
+            is_writing = false;
+            writing_async_body_ = false;
+            res.clear();
+            buffers_.clear();
+            parser_.clear();
+
+            if (!ok || close_connection_)
+            {
+                if (need_to_start_read_after_complete_)
+                {
+                    // No read is pending: the read loop was paused waiting for this response
+                    need_to_start_read_after_complete_ = false;
+                    is_reading = false;
+                }
+                adaptor_.shutdown_readwrite();
+                adaptor_.close();
+                CROW_LOG_DEBUG << this << " from write (async body)";
+                check_destroy();
+                return;
+            }
+
+            if (need_to_start_read_after_complete_)
+            {
+                need_to_start_read_after_complete_ = false;
+                start_deadline();
+                do_read();
+            }
+        }
+
         void do_write_general()
         {
-            if (res.body.length() < res_stream_threshold_)
+            if (res.is_static_body_type())
+            {
+                // Headers and body in one gather write, straight from the referenced memory
+                buffers_.emplace_back(res.static_body_);
+
+                do_write();
+
+                if (need_to_start_read_after_complete_)
+                {
+                    need_to_start_read_after_complete_ = false;
+                    start_deadline();
+                    do_read();
+                }
+            }
+            else if (res.body.length() < res_stream_threshold_)
             {
                 res_body_copy_.swap(res.body);
                 buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
@@ -11682,27 +12525,75 @@ namespace crow
                       CROW_LOG_DEBUG << this << " from read(1) with description: \"" << http_errno_description(static_cast<http_errno>(parser_.http_errno)) << '\"';
                       check_destroy();
                   }
-                  else if (close_connection_)
-                  {
-                      cancel_deadline_timer();
-                      parser_.done();
-                      is_reading = false;
-                      check_destroy();
-                      // adaptor will close after write
-                  }
-                  else if (!need_to_call_after_handlers_)
+                  else if (waiting_for_sink_ || (!parser_.message_complete && wait_for_sink(false)))
                   {
-                      start_deadline();
-                      do_read();
+                      // resume_from_sink() goes on (is_reading stays set so the connection is kept)
                   }
                   else
                   {
-                      // res will be completed later by user
-                      need_to_start_read_after_complete_ = true;
+                      after_read();
                   }
               });
         }
 
+        void after_read()
+        {
+            if (close_connection_)
+            {
+                cancel_deadline_timer();
+                parser_.done();
+                is_reading = false;
+                check_destroy();
+                // adaptor will close after write
+            }
+            else if (!need_to_call_after_handlers_ && !writing_async_body_)
+            {
+                start_deadline();
+                do_read();
+            }
+            else
+            {
+                // res will be completed later by user
+                need_to_start_read_after_complete_ = true;
+            }
+        }
+
+        /// Ask the body sink whether to go on; if not, stop until it calls back (on this connection's io_service).
+        bool wait_for_sink(bool complete)
+        {
+            if (!parser_.sink)
+                return false;
+            auto& io_service = adaptor_.get_io_service();
+            bool ready = parser_.sink->ready(complete, [this, &io_service, complete] {
+                io_service.post([this, complete] {
+                    resume_from_sink(complete);
+                });
+            });
+            if (ready)
+                return false;
+            waiting_for_sink_ = true;
+            cancel_deadline_timer();
+            return true;
+        }
+
+        void resume_from_sink(bool complete)
+        {
+            waiting_for_sink_ = false;
+            if (!adaptor_.is_open())
+            {
+                is_reading = false;
+                check_destroy();
+                return;
+            }
+            if (complete)
+            {
+                handle();
+                if (waiting_for_sink_)
+                    return;
+            }
+            after_read();
+        }
+
         void do_write()
         {
             //auto self = this->shared_from_this();
@@ -11752,8 +12643,10 @@ namespace crow
 
         void check_destroy()
         {
-            CROW_LOG_DEBUG << this << " is_reading " << is_reading << " is_writing " << is_writing;
-            if (!is_reading && !is_writing)
+            CROW_LOG_DEBUG << this << " is_reading " << is_reading << " is_writing " << is_writing << " pending " << need_to_call_after_handlers_;
+            // A handler that has not called res.end() yet still owns res (and req):
+            // the connection is destroyed after that response is written
+            if (!is_reading && !is_writing && !need_to_call_after_handlers_)
             {
                 queue_length_--;
                 CROW_LOG_DEBUG << this << " delete (idle) (queue length: " << queue_length_ << ')';
@@ -11807,6 +12700,8 @@ namespace crow
         bool is_writing{};
         bool need_to_call_after_handlers_{};
         bool need_to_start_read_after_complete_{};
+        bool waiting_for_sink_{}; ///< Reading (or the handler) is held until the body sink catches up.
+        bool writing_async_body_{};
         bool add_keep_alive_{};
 
         std::tuple<Middlewares...>* middlewares_;
@@ -11877,6 +12772,11 @@ namespace crow
             tick_function_ = f;
         }
 
+        void set_thread_init(std::function<void(uint16_t)> f)
+        {
+            thread_init_ = std::move(f);
+        }
+
         void on_tick()
         {
             tick_function_();
@@ -11902,6 +12802,9 @@ namespace crow
                 v.push_back(
                   std::async(
                     std::launch::async, [this, i, &init_count] {
+                        if (thread_init_)
+                            thread_init_(i);
+
                         // thread local date string get function
                         auto last = std::chrono::steady_clock::now();
 
@@ -11982,7 +12885,9 @@ namespace crow
             do_accept();
 
             std::thread(
-              [this] {
+              [this, worker_thread_count] {
+                  if (thread_init_)
+                      thread_init_(worker_thread_count);
                   io_service_.run();
                   CROW_LOG_INFO << "Exiting.";
               })
@@ -12037,6 +12942,10 @@ namespace crow
               [this, p, &is, service_idx](boost::system::error_code ec) {
                   if (!ec)
                   {
+                      // Responses go out in several gather writes (asio sends at most 16 buffers per call);
+                      // with Nagle the last one waits for the client's delayed ACK (~40 ms per keep-alive request)
+                      boost::system::error_code nodelay_ec;
+                      p->socket().set_option(tcp::no_delay(true), nodelay_ec);
                       is.post(
                         [p] {
                             p->start();
@@ -12071,6 +12980,7 @@ namespace crow
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
+        std::function<void(uint16_t)> thread_init_;
 
         std::tuple<Middlewares...>* middlewares_;
 
@@ -12287,6 +13197,23 @@ namespace crow
             return res_stream_threshold_;
         }
 
+        /// Set a factory that may return a \ref crow.body_sink to stream a request body instead of buffering it.
+
+        ///
+        /// Called once the request headers have been parsed (the URL still contains the query string).
+        self_t& body_sink_factory(std::function<std::shared_ptr<body_sink>(HTTPMethod, const std::string&, const ci_map&)> factory)
+        {
+            body_sink_factory_ = std::move(factory);
+            return *this;
+        }
+
+        std::shared_ptr<body_sink> make_body_sink(HTTPMethod method, const std::string& raw_url, const ci_map& headers)
+        {
+            if (!body_sink_factory_)
+                return nullptr;
+            return body_sink_factory_(method, raw_url, headers);
+        }
+
         self_t& register_blueprint(Blueprint& blueprint)
         {
             router_.register_blueprint(blueprint);
@@ -12302,6 +13229,16 @@ namespace crow
             return *this;
         }
 
+        /// Set a function to run at the start of every server thread (e.g. to set its CPU affinity)
+
+        ///
+        /// It receives the thread index: 0 to concurrency - 2 for the worker io_services, concurrency - 1 for the acceptor.
+        self_t& thread_init(std::function<void(std::uint16_t)> f)
+        {
+            thread_init_ = std::move(f);
+            return *this;
+        }
+
 #ifdef CROW_ENABLE_COMPRESSION
         self_t& use_compression(compression::algorithm algorithm)
         {
@@ -12378,6 +13315,7 @@ namespace crow
             {
                 ssl_server_ = std::move(std::unique_ptr<ssl_server_t>(new ssl_server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, &ssl_context_)));
                 ssl_server_->set_tick_function(tick_interval_, tick_function_);
+                ssl_server_->set_thread_init(thread_init_);
                 ssl_server_->signal_clear();
                 for (auto snum : signals_)
                 {
@@ -12391,6 +13329,7 @@ namespace crow
             {
                 server_ = std::move(std::unique_ptr<server_t>(new server_t(this, bindaddr_, port_, server_name_, &middlewares_, concurrency_, timeout_, nullptr)));
                 server_->set_tick_function(tick_interval_, tick_function_);
+                server_->set_thread_init(thread_init_);
                 server_->signal_clear();
                 for (auto snum : signals_)
                 {
@@ -12557,6 +13496,7 @@ namespace crow
         std::string server_name_ = std::string("Crow/") + VERSION;
         std::string bindaddr_ = "0.0.0.0";
         size_t res_stream_threshold_ = 1048576;
+        std::function<std::shared_ptr<body_sink>(HTTPMethod, const std::string&, const ci_map&)> body_sink_factory_;
         Router router_;
 
 #ifdef CROW_ENABLE_COMPRESSION
@@ -12566,6 +13506,7 @@ namespace crow
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
+        std::function<void(uint16_t)> thread_init_;
 
         std::tuple<Middlewares...> middlewares_;
 
@@ -0,0 +1,148 @@
+#include "BinaryProtocol.h"
+
+namespace BinaryProtocol {
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+size_t appendUtf8(std::string& out, std::string_view value) {
+    static const char replacement[] = "\xEF\xBF\xBD";
+
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(value.data());
+    size_t n = value.size();
+    size_t units = 0;
+    size_t i = 0;
+
+    while (i < n) {
+        // Tramo ASCII: se copia tal cual
+        size_t start = i;
+        while (i < n && s[i] < 0x80) i++;
+        out.append(value, start, i - start);
+        units += i - start;
+        if (i == n) break;
+
+        // Secuencia multibyte: validar (sin overlongs, surrogates ni > U+10FFFF)
+        unsigned char c = s[i];
+        size_t len = 0;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) len = 2;
+        else if (c >= 0xE0 && c <= 0xEF) {
+            len = 3;
+            if (c == 0xE0) lo = 0xA0;
+            if (c == 0xED) hi = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            len = 4;
+            if (c == 0xF0) lo = 0x90;
+            if (c == 0xF4) hi = 0x8F;
+        }
+
+        bool valid = len > 0 && i + len <= n && s[i + 1] >= lo && s[i + 1] <= hi;
+        for (size_t k = 2; valid && k < len; k++) {
+            valid = s[i + k] >= 0x80 && s[i + k] <= 0xBF;
+        }
+
+        if (valid) {
+            out.append(value, i, len);
+            units += len == 4 ? 2 : 1;  // fuera del BMP: par de surrogates
+            i += len;
+        } else {
+            out.append(replacement, 3);
+            units += 1;
+            i += 1;
+        }
+    }
+    return units;
+}
+
+void appendMessage(std::string& headers, std::string& strings, const Message& msg) {
+    bool is_file = msg.isFile();
+    size_t strings_start = strings.size();
+
+    // La IP es ASCII: su largo en bytes es el de UTF-16
+    size_t lengths[3];
+    size_t count = 0;
+    lengths[count++] = appendUtf8(strings, msg.content());
+    size_t mark = strings.size();
+    msg.sender_ip.appendTo(strings);
+    lengths[count++] = strings.size() - mark;
+    if (is_file) {
+        lengths[count++] = appendUtf8(strings, msg.filename());
+    }
+
+    // Campos en un buffer en la pila: van detrás de su propio largo
+    char fields[64];
+    size_t fields_size = 0;
+    auto varint = [&](uint64_t value) {
+        while (value >= 0x80) {
+            fields[fields_size++] = static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        fields[fields_size++] = static_cast<char>(value);
+    };
+    varint(msg.seq);
+    fields[fields_size++] = static_cast<char>(is_file ? 1 : 0);
+    varint(msg.id);
+    varint(static_cast<uint64_t>(msg.timestamp_ms));
+    if (is_file) {
+        varint(msg.filesize);
+    }
+    for (size_t i = 0; i < count; i++) {
+        varint(lengths[i]);
+    }
+
+    // El prefijo de longitud permite saltar campos que añadan versiones futuras
+    appendVarint(headers, fields_size);
+    headers.append(fields, fields_size);
+    appendVarint(headers, strings.size() - strings_start);
+}
+
+std::string initialState(uint64_t since, const MessagePage& messages) {
+    // Primero todas las cabeceras, después todas las cadenas
+    std::string out;
+    std::string strings;
+    size_t total = 0;
+    for (const auto& msg : messages) total += msg->stringsSize() + 16;
+    out.reserve(21 + messages.size() * 32);
+    strings.reserve(total);
+
+    out += static_cast<char>(INITIAL_STATE);
+    appendVarint(out, since);
+    appendVarint(out, messages.size());
+    for (const auto& msg : messages) {
+        appendMessage(out, strings, *msg);
+    }
+    out += strings;
+    return out;
+}
+
+std::string newMessage(const Message& msg) {
+    std::string out(1, static_cast<char>(NEW_MESSAGE));
+    std::string strings;
+    strings.reserve(16 + msg.stringsSize());
+    appendMessage(out, strings, msg);
+    out += strings;
+    return out;
+}
+
+std::string resyncNeeded() {
+    return std::string(1, static_cast<char>(RESYNC_NEEDED));
+}
+
+std::string evicted(uint64_t first_seq, const std::vector<uint64_t>& file_ids) {
+    std::string out;
+    out.reserve(21 + file_ids.size() * 10);
+    out += static_cast<char>(EVICTED);
+    appendVarint(out, first_seq);
+    appendVarint(out, file_ids.size());
+    for (uint64_t id : file_ids) {
+        appendVarint(out, id);
+    }
+    return out;
+}
+
+} // namespace BinaryProtocol
@@ -0,0 +1,57 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "MessageLog.h"
+
+// Protocolo binario de /ws, alternativa compacta al JSON. Se elige con el
+// subprotocolo "autosync.v2.bin" en el handshake y viaja en frames binarios.
+//
+//   frame    = u8 evento, cuerpo
+//     0x01 initial_state: varint since, varint n, n × cabecera, cadenas de los n mensajes
+//     0x02 new_message:   cabecera, cadenas
+//     0x03 resync_needed: (vacío)
+//     0x04 evicted:       varint first_seq, varint n, n × varint id
+//   cabecera = varint longitud de los campos, campos, varint bytes de sus cadenas
+//   campos   = varint seq, u8 tipo (0 texto, 1 archivo), varint id, varint timestamp
+//              (epoch en ms), [archivo: varint filesize], varint largo de content,
+//              sender_ip [y filename]
+//   cadenas  = UTF-8 de content, sender_ip [y filename] concatenadas
+//   varint   = LEB128 sin signo (7 bits por byte, el bit alto indica que sigue)
+//
+// id y timestamp son números (id < 2^53, exacto en un Number de JS): la hora
+// se formatea en el navegador.
+//
+// Los largos de las cadenas van en unidades UTF-16 (String.length en JS): el
+// navegador decodifica todas las cadenas del frame con una sola llamada a
+// TextDecoder y las separa con substring. Por eso el UTF-8 inválido se
+// sustituye por U+FFFD al codificar: así los largos coinciden siempre.
+namespace BinaryProtocol {
+    constexpr const char* SUBPROTOCOL = "autosync.v2.bin";
+
+    enum Event : uint8_t {
+        INITIAL_STATE = 0x01,
+        NEW_MESSAGE = 0x02,
+        RESYNC_NEEDED = 0x03,
+        EVICTED = 0x04
+    };
+
+    void appendVarint(std::string& out, uint64_t value);
+
+    // Añade value a out como UTF-8 válido y devuelve su largo en unidades UTF-16
+    size_t appendUtf8(std::string& out, std::string_view value);
+
+    // Añade la cabecera de msg a headers y sus cadenas a strings
+    void appendMessage(std::string& headers, std::string& strings, const Message& msg);
+
+    std::string initialState(uint64_t since, const MessagePage& messages);
+    std::string newMessage(const Message& msg);
+    std::string resyncNeeded();
+    // Retención: mensajes con seq < first_seq eliminados y archivos sin contenido
+    std::string evicted(uint64_t first_seq, const std::vector<uint64_t>& file_ids);
+}
+
+#endif
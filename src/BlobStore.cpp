@@ -0,0 +1,159 @@
+#include "BlobStore.h"
+#include "Sha256.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+void BlobStore::open(const std::string& dir) {
+    root = dir;
+    if (mkdir(root.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "❌ No se pudo crear " << root << ": " << strerror(errno) << std::endl;
+    }
+}
+
+bool BlobStore::adopt(const std::string& staging_path, const std::string& digest, size_t size,
+                      const std::string& link_path, bool& duplicate) {
+    std::string blob_path = pathFor(digest);
+
+    // Sellar antes de enlazar: el blob es de solo lectura y tiene el tamaño
+    // hasheado. Quien escribía el staging ya cerró su descriptor.
+    int fd = ::open(staging_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "❌ Error al abrir staging " << staging_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    bool sealed = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size && fchmod(fd, 0444) == 0;
+    int err = errno;
+    close(fd);
+    if (!sealed) {
+        std::cerr << "❌ Staging " << staging_path << " no sellado (" << size << " bytes esperados): "
+                  << strerror(err) << std::endl;
+        return false;
+    }
+
+    // link falla con EEXIST si el contenido ya está: la comprobación y la
+    // creación son una sola operación, también entre dos subidas simultáneas
+    std::lock_guard<std::mutex> lock(mtx);
+    if (::link(staging_path.c_str(), blob_path.c_str()) == 0) {
+        duplicate = false;
+        bytes_stored += size;
+    } else if (errno == EEXIST) {
+        duplicate = true;
+        bytes_deduplicated += size;
+    } else {
+        std::cerr << "❌ Error al guardar blob " << digest << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(staging_path.c_str());
+
+    Blob& blob = index.emplace(digest, Blob{size, 0}).first->second;
+    if (!linkLocked(digest, blob, link_path)) {
+        if (blob.links == 0) {
+            unlink(blob_path.c_str());
+            bytes_stored -= blob.size;
+            index.erase(digest);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BlobStore::link(const std::string& digest, size_t size, const std::string& link_path) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(digest);
+    if (it == index.end() || it->second.size != size) return false;
+    return linkLocked(digest, it->second, link_path);
+}
+
+bool BlobStore::linkLocked(const std::string& digest, Blob& blob, const std::string& link_path) {
+    if (::link(pathFor(digest).c_str(), link_path.c_str()) != 0) {
+        std::cerr << "❌ Error al enlazar blob " << digest << " -> " << link_path
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    blob.links++;
+    return true;
+}
+
+uint64_t BlobStore::release(const std::string& digest, const std::string& link_path) {
+    std::lock_guard<std::mutex> lock(mtx);
+    unlink(link_path.c_str());
+
+    auto it = index.find(digest);
+    if (it == index.end() || --it->second.links > 0) return 0;
+
+    uint64_t freed = it->second.size;
+    unlink(pathFor(digest).c_str());
+    bytes_stored -= freed;
+    index.erase(it);
+    return freed;
+}
+
+bool BlobStore::restoreLink(const std::string& digest, size_t size) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(digest);
+    if (it == index.end()) {
+        struct stat st;
+        if (stat(pathFor(digest).c_str(), &st) != 0) return false;
+        it = index.emplace(digest, Blob{size, 0}).first;
+        bytes_stored += size;
+    }
+    it->second.links++;
+    return true;
+}
+
+size_t BlobStore::removeUnreferenced() {
+    std::lock_guard<std::mutex> lock(mtx);
+    DIR* dir = opendir(root.c_str());
+    if (!dir) return 0;
+
+    size_t removed = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") continue;
+        if (index.count(name) == 0 && unlinkat(dirfd(dir), name.c_str(), 0) == 0) {
+            removed++;
+        }
+    }
+    closedir(dir);
+    return removed;
+}
+
+BlobStore::Stats BlobStore::stats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return {index.size(), bytes_stored, bytes_deduplicated};
+}
+
+void BlobStore::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    index.clear();
+    bytes_stored = 0;
+    bytes_deduplicated = 0;
+}
+
+std::string BlobStore::hashFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return "";
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    Sha256 hasher;
+    std::vector<char> buffer(1024 * 1024);
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return "";
+        }
+        if (n == 0) break;
+        hasher.update(buffer.data(), static_cast<size_t>(n));
+    }
+    close(fd);
+    return hasher.finish();
+}
@@ -0,0 +1,75 @@
+#ifndef BLOB_STORE_H
+#define BLOB_STORE_H
+
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Almacén direccionado por contenido: cada contenido distinto se guarda una
+// sola vez en root/<sha256>. Los archivos de los mensajes son hard links al
+// blob, así que un archivo repetido no ocupa disco y la descarga sigue
+// sirviendo temp_dir/<filename> sin saber nada de blobs.
+//
+// Cada blob cuenta los enlaces de mensajes que lo usan; al soltar el último
+// (retención) el blob se borra. Crear y soltar enlaces ocurre bajo el mismo
+// lock, así que un contenido repetido nunca se enlaza a un blob que se está
+// borrando.
+class BlobStore {
+public:
+    struct Stats {
+        size_t blobs;
+        uint64_t bytes_stored;        // ocupado en disco por los blobs
+        uint64_t bytes_deduplicated;  // subidas que no se escribieron por ser repetidas
+    };
+
+    // Crea el directorio si no existe
+    void open(const std::string& root);
+
+    // Convierte staging_path (en el mismo sistema de archivos) en el blob de
+    // digest y lo enlaza en link_path. Si el contenido ya estaba, el staging se
+    // descarta y duplicate = true. El staging debe estar cerrado para escritura:
+    // se deja en solo lectura y se comprueba que mide size antes de enlazarlo.
+    bool adopt(const std::string& staging_path, const std::string& digest, size_t size,
+               const std::string& link_path, bool& duplicate);
+
+    // Crea link_path como hard link al blob; false si no hay un blob de ese
+    // digest y tamaño
+    bool link(const std::string& digest, size_t size, const std::string& link_path);
+
+    // Borra link_path y, si era el último enlace, el blob. Devuelve los bytes
+    // liberados en disco (0 si el contenido sigue en uso).
+    uint64_t release(const std::string& digest, const std::string& link_path);
+
+    Stats stats();
+
+    // Arranque en modo persistente: cuenta un enlace recuperado a un blob que ya
+    // está en disco; false si el blob no existe
+    bool restoreLink(const std::string& digest, size_t size);
+    // Borra los blobs sin ningún enlace (p. ej. de una subida cortada por un crash)
+    size_t removeUnreferenced();
+
+    // Olvida el índice (los archivos se borran con temp_dir)
+    void clear();
+
+    // SHA-256 de un archivo ya escrito; vacío si no se puede leer
+    static std::string hashFile(const std::string& path);
+
+private:
+    struct Blob {
+        size_t size;
+        size_t links;  // archivos de mensajes que apuntan al blob
+    };
+
+    std::string root;
+    std::mutex mtx;
+    std::unordered_map<std::string, Blob> index;  // digest -> blob
+    uint64_t bytes_stored = 0;
+    uint64_t bytes_deduplicated = 0;
+
+    std::string pathFor(const std::string& digest) const { return root + "/" + digest; }
+    bool linkLocked(const std::string& digest, Blob& blob, const std::string& link_path);
+};
+
+#endif
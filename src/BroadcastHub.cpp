@@ -0,0 +1,120 @@
+#include "BroadcastHub.h"
+#include "../include/crow_all.h"
+#include <iostream>
+
+BroadcastHub::BroadcastHub() : clients(std::make_shared<const Registry>()) {}
+
+void BroadcastHub::configure(const Config& new_config) {
+    std::lock_guard<std::mutex> lock(mtx);
+    config = new_config;
+}
+
+void BroadcastHub::add(crow::websocket::connection& conn, bool binary) {
+    auto client = std::make_shared<Client>();
+    client->conn = &conn;
+    client->binary = binary;
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    crow::websocket::send_budget budget;
+    budget.max_bytes = config.max_queued_bytes;
+    budget.max_frames = config.max_queued_messages;
+    switch (config.policy) {
+        case OverflowPolicy::Disconnect: budget.policy = crow::websocket::overflow_policy::disconnect; break;
+        case OverflowPolicy::DropOldest: budget.policy = crow::websocket::overflow_policy::drop_oldest; break;
+        case OverflowPolicy::Resync: budget.policy = crow::websocket::overflow_policy::resync; break;
+    }
+    if (config.policy == OverflowPolicy::Resync) {
+        budget.resync_frame = binary ? crow::websocket::make_frame(0x2, config.resync_binary)
+                                     : crow::websocket::make_frame(0x1, config.resync_message);
+    }
+
+    // Se ejecuta en el hilo de la conexión, que es el único que toca client->throttled
+    OverflowPolicy policy_in_use = config.policy;
+    budget.on_overflow = [this, client, policy_in_use](const crow::websocket::overflow_event& event) {
+        if (!client->throttled) {
+            client->throttled = true;
+            clients_throttled++;
+            std::cout << "🐢 Cliente WebSocket lento: aplicando política " << policyName(policy_in_use) << std::endl;
+        }
+        messages_dropped += event.dropped;
+        if (event.resync_queued) resyncs_sent++;
+        if (event.disconnected) clients_disconnected++;
+    };
+    conn.set_send_budget(std::move(budget));
+
+    auto updated = std::make_shared<Registry>(*clients);
+    updated->push_back(std::move(client));
+    clients = std::move(updated);
+}
+
+void BroadcastHub::remove(crow::websocket::connection& conn) {
+    std::shared_ptr<Client> removed;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto updated = std::make_shared<Registry>();
+        updated->reserve(clients->size());
+        for (const auto& client : *clients) {
+            if (client->conn == &conn) {
+                removed = client;
+            } else {
+                updated->push_back(client);
+            }
+        }
+        clients = std::move(updated);
+    }
+
+    // Un broadcast con una instantánea anterior puede seguir usando este cliente
+    if (removed) {
+        std::lock_guard<std::mutex> lock(removed->mtx);
+        removed->conn = nullptr;
+    }
+}
+
+BroadcastHub::Stats BroadcastHub::stats() const {
+    return {clients_throttled.load(), messages_dropped.load(), resyncs_sent.load(), clients_disconnected.load()};
+}
+
+bool BroadcastHub::parsePolicy(const std::string& name, OverflowPolicy& policy) {
+    if (name == "disconnect") policy = OverflowPolicy::Disconnect;
+    else if (name == "drop-oldest") policy = OverflowPolicy::DropOldest;
+    else if (name == "resync") policy = OverflowPolicy::Resync;
+    else return false;
+    return true;
+}
+
+const char* BroadcastHub::policyName(OverflowPolicy policy) {
+    switch (policy) {
+        case OverflowPolicy::Disconnect: return "disconnect";
+        case OverflowPolicy::DropOldest: return "drop-oldest";
+        case OverflowPolicy::Resync: return "resync";
+    }
+    return "";
+}
+
+size_t BroadcastHub::size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return clients->size();
+}
+
+void BroadcastHub::broadcast(const std::string& json_payload, const std::string& binary_payload) {
+    std::shared_ptr<const Registry> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        snapshot = clients;
+    }
+
+    crow::websocket::shared_message_ptr text_message, binary_message;
+    for (const auto& client : *snapshot) {
+        auto& message = client->binary ? binary_message : text_message;
+        if (!message) {
+            message = client->binary ? std::make_shared<const crow::websocket::shared_message>(0x2, binary_payload)
+                                     : std::make_shared<const crow::websocket::shared_message>(0x1, json_payload);
+        }
+        
+        std::lock_guard<std::mutex> lock(client->mtx);
+        if (client->conn) {
+            client->conn->send_message(message);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef BROADCAST_HUB_H
+#define BROADCAST_HUB_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace crow { namespace websocket { struct connection; } }
+
+// Registro de clientes WebSocket y difusión de mensajes.
+//
+// Cada broadcast crea un único mensaje compartido por todos los clientes: el
+// frame plano y el comprimido (permessage-deflate sin context takeover) se
+// construyen una sola vez cada uno. El registro es copy-on-write: difundir solo
+// copia un puntero bajo el lock, así que conectar/desconectar nunca espera a
+// que termine un broadcast.
+class BroadcastHub {
+public:
+    // Qué hacer con un cliente que no lee y supera su presupuesto de envío
+    enum class OverflowPolicy {
+        Disconnect,  // cerrar la conexión
+        DropOldest,  // descartar los broadcasts más antiguos aún no enviados
+        Resync       // descartar todo lo pendiente y avisar una vez con resync_message
+    };
+
+    struct Config {
+        size_t max_queued_bytes = 8 * 1024 * 1024;  // 0 = sin límite
+        size_t max_queued_messages = 1024;          // 0 = sin límite
+        OverflowPolicy policy = OverflowPolicy::Resync;
+        std::string resync_message;                 // payload del aviso para clientes JSON
+        std::string resync_binary;                  // ídem para clientes binarios
+    };
+
+    struct Stats {
+        uint64_t clients_throttled;     // clientes distintos que superaron el presupuesto
+        uint64_t messages_dropped;
+        uint64_t resyncs_sent;
+        uint64_t clients_disconnected;
+    };
+
+    BroadcastHub();
+
+    // Afecta a los clientes que se conecten después
+    void configure(const Config& config);
+
+    // binary: el cliente negoció el protocolo binario y recibe frames binarios
+    void add(crow::websocket::connection& conn, bool binary);
+    // Al volver no queda ningún envío en curso hacia conn: Crow ya puede destruirla
+    void remove(crow::websocket::connection& conn);
+    size_t size() const;
+    Stats stats() const;
+
+    // Cada cliente recibe la codificación de su protocolo, comprimida o no según
+    // lo que negoció; nada se codifica ni comprime si ningún cliente lo necesita
+    void broadcast(const std::string& json_payload, const std::string& binary_payload);
+
+    // "disconnect", "drop-oldest" o "resync"
+    static bool parsePolicy(const std::string& name, OverflowPolicy& policy);
+    static const char* policyName(OverflowPolicy policy);
+
+private:
+    struct Client {
+        std::mutex mtx;  // protege conn frente a remove()
+        crow::websocket::connection* conn;
+        bool binary = false;
+        bool throttled = false;  // solo desde el hilo de la conexión
+    };
+    using Registry = std::vector<std::shared_ptr<Client>>;
+
+    mutable std::mutex mtx;
+    std::shared_ptr<const Registry> clients;
+    Config config;
+
+    std::atomic<uint64_t> clients_throttled{0};
+    std::atomic<uint64_t> messages_dropped{0};
+    std::atomic<uint64_t> resyncs_sent{0};
+    std::atomic<uint64_t> clients_disconnected{0};
+};
+
+#endif
@@ -0,0 +1,276 @@
+#include "ChunkedUploadManager.h"
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+UploadSession::~UploadSession() {
+    if (fd >= 0) close(fd);
+    if (!staging_path.empty()) unlink(staging_path.c_str());
+}
+
+UploadSession::WriteResult UploadSession::write(size_t offset, const char* data, size_t length) {
+    if (offset > size || length > size - offset) {
+        return WriteResult::OutOfRange;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (sealed) return WriteResult::Conflict;
+        // Lo recibido puede estar ya en el hash: no se reescribe
+        auto it = received.lower_bound(offset + length);
+        if (it != received.begin() && std::prev(it)->second > offset) return WriteResult::Conflict;
+        writing.insert(offset);
+    }
+
+    // pwrite es seguro con varios hilos escribiendo en offsets distintos
+    bool ok = true;
+    size_t at = offset;
+    while (length > 0) {
+        ssize_t n = pwrite(fd, data, length, static_cast<off_t>(at));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "❌ Error escribiendo trozo de " << id << ": " << strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        data += n;
+        at += static_cast<size_t>(n);
+        length -= static_cast<size_t>(n);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writing.erase(writing.find(offset));
+    }
+    idle.notify_all();
+    return ok ? WriteResult::Ok : WriteResult::Error;
+}
+
+void UploadSession::markReceived(size_t offset, size_t length) {
+    if (length == 0) return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    last_activity = std::chrono::steady_clock::now();
+
+    size_t start = offset;
+    size_t end = offset + length;
+
+    // Fusionar con los intervalos que se solapan o tocan
+    auto it = received.upper_bound(start);
+    if (it != received.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            it = received.erase(prev);
+        }
+    }
+    while (it != received.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = received.erase(it);
+    }
+    received[start] = end;
+}
+
+size_t UploadSession::receivedBytes() {
+    std::lock_guard<std::mutex> lock(mtx);
+    size_t total = 0;
+    for (const auto& r : received) total += r.second - r.first;
+    return total;
+}
+
+std::vector<std::pair<size_t, size_t>> UploadSession::receivedRanges() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return std::vector<std::pair<size_t, size_t>>(received.begin(), received.end());
+}
+
+void UploadSession::advanceHash() {
+    std::unique_lock<std::mutex> hash_lock(hash_mtx, std::try_to_lock);
+    if (!hash_lock.owns_lock()) return;
+
+    if (fd < 0) return;  // ya sellada: finishHash lee el resto
+
+    size_t contiguous = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto first = received.begin();
+        if (first != received.end() && first->first == 0) contiguous = first->second;
+        // Un PUT repetido que empezó antes de que su rango se marcara puede
+        // seguir escribiendo ahí: el hash se queda por debajo
+        if (!writing.empty()) contiguous = std::min(contiguous, *writing.begin());
+    }
+    hashUpTo(fd, contiguous);
+}
+
+void UploadSession::seal() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        sealed = true;
+        idle.wait(lock, [this] { return writing.empty(); });
+    }
+    // Un advanceHash en curso todavía lee de fd
+    std::lock_guard<std::mutex> hash_lock(hash_mtx);
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+std::string UploadSession::finishHash() {
+    std::lock_guard<std::mutex> hash_lock(hash_mtx);
+    int read_fd = open(staging_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (read_fd < 0) {
+        std::cerr << "❌ Error abriendo " << id << " para el hash: " << strerror(errno) << std::endl;
+        return "";
+    }
+    bool ok = hashUpTo(read_fd, size);
+    close(read_fd);
+    return ok ? hasher.finish() : "";
+}
+
+bool UploadSession::hashUpTo(int read_fd, size_t end) {
+    // Los trozos se acaban de escribir: normalmente se leen de la page cache
+    std::vector<char> buffer(std::min<size_t>(end - std::min(hashed, end), 1024 * 1024));
+    while (hashed < end) {
+        size_t want = std::min(buffer.size(), end - hashed);
+        ssize_t n = pread(read_fd, buffer.data(), want, static_cast<off_t>(hashed));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            std::cerr << "❌ Error leyendo " << id << " para el hash: " << strerror(errno) << std::endl;
+            return false;
+        }
+        hasher.update(buffer.data(), static_cast<size_t>(n));
+        hashed += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+ChunkedUploadManager::ChunkedUploadManager(const std::string& staging_dir) : staging_dir(staging_dir) {}
+
+ChunkedUploadManager::~ChunkedUploadManager() {
+    stop();
+}
+
+void ChunkedUploadManager::start() {
+    if (sweeper.joinable()) return;
+    stopping = false;
+    sweeper = std::thread(&ChunkedUploadManager::runSweeper, this);
+}
+
+void ChunkedUploadManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sweep_mtx);
+        stopping = true;
+    }
+    sweep_wake.notify_one();
+    if (sweeper.joinable()) sweeper.join();
+}
+
+void ChunkedUploadManager::runSweeper() {
+    std::unique_lock<std::mutex> lock(sweep_mtx);
+    while (!sweep_wake.wait_for(lock, SWEEP_INTERVAL, [this] { return stopping; })) {
+        lock.unlock();
+        expireStale();
+        lock.lock();
+    }
+}
+
+std::string ChunkedUploadManager::generateUploadId() {
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    char buf[33];
+    snprintf(buf, sizeof(buf), "%016llx%016llx",
+             static_cast<unsigned long long>(gen()), static_cast<unsigned long long>(gen()));
+    return buf;
+}
+
+std::shared_ptr<UploadSession> ChunkedUploadManager::create(const std::string& filename, size_t size, const std::string& sender_ip) {
+    auto session = std::make_shared<UploadSession>();
+    session->id = generateUploadId();
+    session->filename = filename;
+    session->sender_ip = sender_ip;
+    session->size = size;
+    session->staging_path = staging_dir + "/.chunked_" + session->id;
+    session->last_activity = std::chrono::steady_clock::now();
+
+    session->fd = open(session->staging_path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (session->fd < 0) {
+        std::cerr << "❌ Error al crear archivo de subida: " << strerror(errno) << std::endl;
+        session->staging_path.clear();
+        return nullptr;
+    }
+
+    // Reservar el espacio ahora: sin fragmentación y sin ENOSPC a mitad de subida
+    if (size > 0) {
+        int err = fallocate(session->fd, 0, 0, static_cast<off_t>(size)) == 0 ? 0 : errno;
+        if (err == EOPNOTSUPP || err == ENOSYS) {
+            err = ftruncate(session->fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+        }
+        if (err != 0) {
+            std::cerr << "❌ No se pudo reservar " << size << " bytes: " << strerror(err) << std::endl;
+            return nullptr;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    sessions[session->id] = session;
+
+    std::cout << "📤 Subida por trozos iniciada: " << session->id << " (" << filename << ", " << size << " bytes)" << std::endl;
+    return session;
+}
+
+std::shared_ptr<UploadSession> ChunkedUploadManager::get(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = sessions.find(id);
+    return it != sessions.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<UploadSession> ChunkedUploadManager::takeCompleted(const std::string& id) {
+    std::shared_ptr<UploadSession> session;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return nullptr;
+        if (it->second->receivedBytes() != it->second->size) return nullptr;
+
+        session = it->second;
+        sessions.erase(it);
+    }
+    session->seal();
+    return session;
+}
+
+void ChunkedUploadManager::abort(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (sessions.erase(id)) {
+        std::cout << "🗑️  Subida cancelada: " << id << std::endl;
+    }
+}
+
+void ChunkedUploadManager::expireStale() {
+    // Se sueltan fuera del lock: la última referencia borra el staging
+    std::vector<std::shared_ptr<UploadSession>> expired;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            bool stale;
+            {
+                std::lock_guard<std::mutex> session_lock(it->second->mtx);
+                stale = now - it->second->last_activity > SESSION_TTL;
+            }
+            if (stale) {
+                std::cout << "⌛ Subida abandonada eliminada: " << it->first << std::endl;
+                expired.push_back(std::move(it->second));
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
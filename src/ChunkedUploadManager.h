@@ -0,0 +1,108 @@
+#ifndef CHUNKED_UPLOAD_MANAGER_H
+#define CHUNKED_UPLOAD_MANAGER_H
+
+#include <string>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include "Sha256.h"
+
+// Subida reanudable: el archivo se preasigna en temp_dir y los trozos se
+// escriben con pwrite en su offset, en cualquier orden y en paralelo. El
+// SHA-256 avanza sobre el prefijo contiguo a medida que se completa, así que
+// al finalizar apenas queda nada por leer.
+//
+// Un byte se escribe una sola vez: un PUT que se solapa con lo ya recibido se
+// rechaza, y el hash nunca lee por encima de un pwrite en curso. Al finalizar,
+// seal() cierra la sesión a nuevas escrituras, espera a las que están en marcha
+// y cierra el descriptor de escritura antes de hashear y publicar.
+struct UploadSession {
+    enum class WriteResult { Ok, OutOfRange, Conflict, Error };
+
+    std::string id;
+    std::string filename;
+    std::string sender_ip;
+    std::string staging_path;
+    size_t size = 0;
+    int fd = -1;
+
+    std::mutex mtx;                          // protege received, writing, sealed y last_activity
+    std::map<size_t, size_t> received;       // intervalos [inicio, fin) ya escritos, fusionados
+    std::multiset<size_t> writing;           // offsets de los pwrite en curso
+    bool sealed = false;                     // finalizada: no admite más escrituras
+    std::condition_variable idle;            // writing se ha vaciado
+    std::chrono::steady_clock::time_point last_activity;
+
+    std::mutex hash_mtx;  // un solo hilo avanza el hash; protege hasher, hashed y el cierre de fd
+    Sha256 hasher;
+    size_t hashed = 0;    // [0, hashed) ya está en hasher
+
+    ~UploadSession();
+
+    // Escribe en [offset, offset + length). Conflict si el rango se solapa con
+    // lo ya recibido o la sesión está sellada
+    WriteResult write(size_t offset, const char* data, size_t length);
+    void markReceived(size_t offset, size_t length);
+    size_t receivedBytes();
+    std::vector<std::pair<size_t, size_t>> receivedRanges();
+
+    // Hashea lo recibido de forma contigua desde el inicio; si otro hilo ya lo
+    // está haciendo vuelve sin esperar
+    void advanceHash();
+    // No admite más escrituras, espera a las que están en curso y cierra fd
+    void seal();
+    // Digest del archivo completo, leído con un descriptor de solo lectura
+    // (después de seal()); vacío si falla la lectura
+    std::string finishHash();
+
+private:
+    bool hashUpTo(int read_fd, size_t end);
+};
+
+class ChunkedUploadManager {
+public:
+    static constexpr size_t CHUNK_SIZE = 8 * 1024 * 1024;      // tamaño recomendado al cliente
+    static constexpr size_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;  // mayor que esto se rechaza
+
+    explicit ChunkedUploadManager(const std::string& staging_dir);
+    ~ChunkedUploadManager();
+
+    // Hilo que elimina las sesiones abandonadas cada SWEEP_INTERVAL
+    void start();
+    void stop();
+
+    // Crea la sesión y preasigna el archivo; nullptr si no hay espacio o falla el disco
+    std::shared_ptr<UploadSession> create(const std::string& filename, size_t size, const std::string& sender_ip);
+    std::shared_ptr<UploadSession> get(const std::string& id);
+
+    // Saca la sesión del registro si está completa y la sella (puede esperar a
+    // un pwrite en curso): el llamador publica el archivo. Devuelve nullptr (y
+    // deja la sesión) si faltan trozos.
+    std::shared_ptr<UploadSession> takeCompleted(const std::string& id);
+    void abort(const std::string& id);
+
+private:
+    static constexpr std::chrono::hours SESSION_TTL{24};
+    static constexpr std::chrono::minutes SWEEP_INTERVAL{10};
+
+    std::string staging_dir;
+    std::mutex mtx;
+    std::map<std::string, std::shared_ptr<UploadSession>> sessions;
+
+    std::mutex sweep_mtx;
+    std::condition_variable sweep_wake;
+    bool stopping = false;
+    std::thread sweeper;
+
+    std::string generateUploadId();
+    void expireStale();
+    void runSweeper();
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "DownloadEngine.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int PIPE_SIZE = 1024 * 1024;
+constexpr size_t PREAD_SLICE = 256 * 1024;  // sin splice: bytes por lectura
+
+// Una transferencia en curso. Se mantiene viva con shared_ptr capturados
+// en los handlers pendientes del io_context y en las tareas del pool.
+//
+// Solo el pool toca el disco: lleva cada trozo del archivo a un pipe con
+// splice (o a pending_write con pread si el sistema de archivos no lo
+// soporta). Un fallo de page cache bloquea ese hilo del pool, no el
+// io_context, que solo vacía el pipe hacia el socket sin bloquear. El pool
+// y el io_context se alternan: nunca usan los campos a la vez.
+class FileTransfer : public std::enable_shared_from_this<FileTransfer> {
+public:
+    FileTransfer(boost::asio::ip::tcp::socket& socket, ThreadPool& pool, std::shared_ptr<OpenFile> file,
+                 std::vector<DownloadEngine::Segment> segments, std::string trailer, DownloadEngine::Done done)
+        : socket(socket), pool(pool), file(std::move(file)), segments(std::move(segments)),
+          trailer(std::move(trailer)), done(std::move(done)) {}
+
+    ~FileTransfer() {
+        if (pipe_fds[0] >= 0) close(pipe_fds[0]);
+        if (pipe_fds[1] >= 0) close(pipe_fds[1]);
+    }
+
+    void start() {
+        boost::system::error_code ec;
+        socket.native_non_blocking(true, ec);
+        if (ec) {
+            std::cerr << "❌ Descarga: no se pudo preparar el socket: " << ec.message() << std::endl;
+            finish(false);
+            return;
+        }
+        if (!setupPipe()) {
+            use_pread = true;
+        }
+        step();
+    }
+
+private:
+    boost::asio::ip::tcp::socket& socket;
+    ThreadPool& pool;
+    std::shared_ptr<OpenFile> file;
+    std::vector<DownloadEngine::Segment> segments;
+    size_t next_segment = 0;
+    std::string trailer;
+    std::string pending_write;  // prefijo, trailer o datos leídos con pread en vuelo
+    off_t offset = 0;
+    size_t remaining = 0;
+    DownloadEngine::Done done;
+
+    bool use_pread = false;
+    int pipe_fds[2] = {-1, -1};
+    size_t pipe_capacity = 0;
+    size_t in_pipe = 0;
+
+    // En el io_context: vacía el pipe y pide al pool el siguiente trozo
+    void step() {
+        while (true) {
+            if (in_pipe > 0) {
+                ssize_t n = splice(pipe_fds[0], nullptr, socket.native_handle(), nullptr, in_pipe,
+                                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+                if (n > 0) {
+                    in_pipe -= static_cast<size_t>(n);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    auto self = shared_from_this();
+                    socket.async_wait(boost::asio::ip::tcp::socket::wait_write,
+                                      [self](const boost::system::error_code& ec) {
+                                          if (ec) {
+                                              self->finish(false);
+                                          } else {
+                                              self->step();
+                                          }
+                                      });
+                    return;
+                }
+                if (n < 0 && errno != EPIPE && errno != ECONNRESET) {
+                    std::cerr << "❌ Descarga: " << strerror(errno) << std::endl;
+                }
+                finish(false);
+                return;
+            }
+
+            if (remaining > 0) {
+                readNext();
+                return;
+            }
+
+            // Segmento terminado: pasar al siguiente, o al trailer
+            if (next_segment < segments.size()) {
+                auto& segment = segments[next_segment++];
+                offset = segment.offset;
+                remaining = segment.length;
+                if (!segment.prefix.empty()) {
+                    writeString(std::move(segment.prefix));
+                    return;
+                }
+                continue;
+            }
+            if (!trailer.empty()) {
+                writeString(std::move(trailer));
+                trailer.clear();
+                return;
+            }
+            break;
+        }
+
+        finish(true);
+    }
+
+    // El siguiente trozo se lee en el pool; al terminar sigue step() en el io_context
+    void readNext() {
+        auto self = shared_from_this();
+        pool.post([self] {
+            int error = self->readSlice();
+            boost::asio::post(self->socket.get_executor(), [self, error] {
+                if (error != 0) {
+                    if (error < 0) {
+                        std::cerr << "❌ Descarga: el archivo terminó antes de lo esperado" << std::endl;
+                    } else {
+                        std::cerr << "❌ Descarga: " << strerror(error) << std::endl;
+                    }
+                    self->finish(false);
+                } else if (self->use_pread) {
+                    self->writePending();
+                } else {
+                    self->step();
+                }
+            });
+        });
+    }
+
+    // En el pool: 0 si leyó algo, errno si falló, -1 si el archivo se acabó antes
+    int readSlice() {
+        while (true) {
+            ssize_t n;
+            if (!use_pread) {
+                size_t chunk = std::min(remaining, pipe_capacity);
+                // NONBLOCK solo afecta al pipe: si un trozo ocupa más páginas de las
+                // previstas se llena en parte en vez de esperar a un lector que no llega
+                n = splice(file->fd, &offset, pipe_fds[1], nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                    // Sistemas de archivos sin soporte de splice
+                    use_pread = true;
+                    continue;
+                }
+                if (n > 0) in_pipe = static_cast<size_t>(n);
+            } else {
+                pending_write.resize(std::min(remaining, PREAD_SLICE));
+                n = pread(file->fd, &pending_write[0], pending_write.size(), offset);
+                if (n > 0) {
+                    pending_write.resize(static_cast<size_t>(n));
+                    offset += n;
+                }
+            }
+
+            if (n > 0) {
+                remaining -= static_cast<size_t>(n);
+                return 0;
+            }
+            if (n == 0) return -1;
+            if (errno != EINTR) return errno;
+        }
+    }
+
+    bool setupPipe() {
+        if (pipe2(pipe_fds, O_CLOEXEC) != 0) {
+            return false;
+        }
+        fcntl(pipe_fds[1], F_SETPIPE_SZ, PIPE_SIZE);  // si falla se usa el tamaño por defecto
+        int capacity = fcntl(pipe_fds[1], F_GETPIPE_SZ);
+        // El pool nunca pide más de lo que cabe: el splice hacia el pipe no espera a que se vacíe
+        pipe_capacity = capacity > 0 ? static_cast<size_t>(capacity) : 64 * 1024;
+        return true;
+    }
+
+    void writeString(std::string data) {
+        pending_write = std::move(data);
+        writePending();
+    }
+
+    void writePending() {
+        auto self = shared_from_this();
+        boost::asio::async_write(socket, boost::asio::buffer(pending_write),
+                                 [self](const boost::system::error_code& ec, std::size_t) {
+                                     if (ec) {
+                                         self->finish(false);
+                                     } else {
+                                         self->step();
+                                     }
+                                 });
+    }
+
+    void finish(bool ok) {
+        // Crow sigue usando escrituras síncronas en esta conexión
+        boost::system::error_code ec;
+        socket.native_non_blocking(false, ec);
+
+        if (done) {
+            auto callback = std::move(done);
+            done = nullptr;
+            callback(ok);
+        }
+    }
+};
+
+} // namespace
+
+OpenFile::~OpenFile() {
+    if (fd >= 0) close(fd);
+}
+
+std::shared_ptr<OpenFile> DownloadEngine::open(const std::string& path) {
+    auto file = std::make_shared<OpenFile>();
+    file->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+        return nullptr;
+    }
+    if (fstat(file->fd, &file->st) != 0 || !S_ISREG(file->st.st_mode)) {
+        return nullptr;
+    }
+    posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return file;
+}
+
+void DownloadEngine::send(boost::asio::ip::tcp::socket& socket, ThreadPool& pool, std::shared_ptr<OpenFile> file,
+                          std::vector<Segment> segments, std::string trailer, Done done) {
+    auto transfer = std::make_shared<FileTransfer>(socket, pool, std::move(file), std::move(segments),
+                                                   std::move(trailer), std::move(done));
+    transfer->start();
+}
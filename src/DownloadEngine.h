@@ -0,0 +1,49 @@
+#ifndef DOWNLOAD_ENGINE_H
+#define DOWNLOAD_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <boost/asio.hpp>
+#include "ThreadPool.h"
+
+// Archivo abierto para descarga: el descriptor se cierra al soltar el último shared_ptr
+struct OpenFile {
+    int fd = -1;
+    struct stat st;
+
+    ~OpenFile();
+    size_t size() const { return static_cast<size_t>(st.st_size); }
+};
+
+// Motor de descargas zero-copy.
+// Envía rangos de un archivo con splice(2): un hilo del pool de disco lleva
+// cada trozo del archivo a un pipe (la única parte que puede esperar al
+// disco) y el io_context de la conexión lo pasa del pipe al socket. Cuando el
+// socket se llena se espera con async_wait en lugar de bloquear el hilo de red.
+// Sin splice en el sistema de archivos se lee con pread en el pool.
+class DownloadEngine {
+public:
+    using Done = std::function<void(bool ok)>;
+
+    // Trozo del archivo a enviar, precedido opcionalmente por bytes propios
+    // (las cabeceras de cada parte en multipart/byteranges)
+    struct Segment {
+        std::string prefix;
+        off_t offset = 0;
+        size_t length = 0;
+    };
+
+    // nullptr si el archivo no existe o no es un archivo regular
+    static std::shared_ptr<OpenFile> open(const std::string& path);
+
+    // Transfiere los segmentos en orden y, al final, trailer; llama a done(ok)
+    // en el io_context del socket
+    static void send(boost::asio::ip::tcp::socket& socket, ThreadPool& pool, std::shared_ptr<OpenFile> file,
+                     std::vector<Segment> segments, std::string trailer, Done done);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef EMBEDDED_RESOURCES_TABLE_H
+#define EMBEDDED_RESOURCES_TABLE_H
+
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Tipos de los recursos embebidos. Los datos los genera embed_resources.cmake
+// en resources.h; aquí solo está lo que no depende de ellos.
+namespace Resources {
+
+// Variante precomprimida; size == 0 si no existe
+struct Encoded {
+    const unsigned char* data;
+    size_t size;
+    std::string_view etag;
+
+    std::string_view bytes() const { return {reinterpret_cast<const char*>(data), size}; }
+};
+
+struct Resource {
+    std::string_view content;
+    std::string_view mime_type;
+    std::string_view etag;         // ETag fuerte del contenido sin comprimir
+    std::string_view hashed_path;  // ruta con huella (cacheable para siempre); vacía en los .html
+    Encoded gzip;
+    Encoded brotli;
+};
+
+struct Entry {
+    std::string_view path;  // sin la '/' inicial
+    const Resource* resource;
+    bool fingerprinted;     // path es la ruta con huella
+};
+
+// FNV-1a de 32 bits con semilla
+constexpr uint32_t hashPath(std::string_view path, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : path) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Tabla hash perfecta construida al compilar: se busca una semilla con la que
+// ninguna ruta comparte posición, así una búsqueda es un hash, un acceso y una
+// comparación, sin reservar memoria.
+template<size_t N>
+class PerfectHashTable {
+public:
+    // Potencia de dos con al menos el doble de posiciones que rutas
+    static constexpr size_t SLOTS = [] {
+        size_t slots = 1;
+        while (slots < 2 * N) slots <<= 1;
+        return slots;
+    }();
+
+    constexpr explicit PerfectHashTable(const std::array<Entry, N>& entries)
+        : entries(entries), seed(findSeed(entries)), slots(build(entries, seed)) {}
+
+    // Admite la ruta con o sin '/' inicial; nullptr si no existe
+    constexpr const Entry* find(std::string_view path) const {
+        if (!path.empty() && path.front() == '/') path.remove_prefix(1);
+        int16_t slot = slots[hashPath(path, seed) & (SLOTS - 1)];
+        if (slot < 0 || entries[slot].path != path) return nullptr;
+        return &entries[slot];
+    }
+
+private:
+    std::array<Entry, N> entries;
+    uint32_t seed;
+    std::array<int16_t, SLOTS> slots;  // índice en entries, -1 si vacía
+
+    static constexpr bool collides(const std::array<Entry, N>& entries, uint32_t seed) {
+        std::array<bool, SLOTS> used{};
+        for (const auto& entry : entries) {
+            size_t slot = hashPath(entry.path, seed) & (SLOTS - 1);
+            if (used[slot]) return true;
+            used[slot] = true;
+        }
+        return false;
+    }
+
+    static constexpr uint32_t findSeed(const std::array<Entry, N>& entries) {
+        for (uint32_t seed = 0; seed < 100000; seed++) {
+            if (!collides(entries, seed)) return seed;
+        }
+        // Al evaluarse en tiempo de compilación esto es un error de compilación
+        throw "No hay semilla sin colisiones: ¿rutas repetidas?";
+    }
+
+    static constexpr std::array<int16_t, SLOTS> build(const std::array<Entry, N>& entries, uint32_t seed) {
+        std::array<int16_t, SLOTS> slots{};
+        for (auto& slot : slots) slot = -1;
+        for (size_t i = 0; i < N; i++) {
+            slots[hashPath(entries[i].path, seed) & (SLOTS - 1)] = static_cast<int16_t>(i);
+        }
+        return slots;
+    }
+};
+
+} // namespace Resources
+
+#endif
@@ -2,15 +2,26 @@
 
 #include "FileManager.h"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 #include <chrono>
-#include <random>
 #include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_set>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
+namespace {
+
+int64_t currentTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 FileManager::FileManager() {
     // Obtener el directorio del ejecutable
     char buffer[1024];
@@ -26,7 +37,9 @@ FileManager::FileManager() {
         temp_dir = "./temp_shared";
     }
     
+    next_stored_id = static_cast<uint64_t>(currentTimeMs() - MessageLog::ID_EPOCH_MS) << MessageLog::ID_SEQUENCE_BITS;
     ensureTempDirExists();
+    blobs.open(temp_dir + "/.blobs");
     std::cout << "📁 Directorio temporal: " << temp_dir << std::endl;
 }
 
@@ -41,92 +54,292 @@ void FileManager::ensureTempDirExists() {
     }
 }
 
-std::string FileManager::generateId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(100000, 999999);
+MessagePtr FileManager::addTextMessage(const std::string& text, const std::string& sender_ip) {
+    MessageDraft draft;
+    draft.type = MessageType::Text;
+    draft.content = text;
+    draft.sender_ip = IpAddress::parse(sender_ip);
     
-    auto now = std::chrono::system_clock::now().time_since_epoch().count();
-    return std::to_string(now) + "_" + std::to_string(dis(gen));
+    auto msg = log.append(draft);
+    if (!msg) {
+        std::cerr << "❌ Historial lleno, mensaje descartado" << std::endl;
+        return nullptr;
+    }
+    if (journal) {
+        journal->commit();
+    }
+    
+    std::cout << "💬 Mensaje de texto agregado: " << msg->id << std::endl;
+    return msg;
 }
 
-std::string FileManager::getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+MessagePtr FileManager::addFileMessageFromStaging(const std::string& filename, const std::string& staging_path, size_t filesize,
+                                                  const std::string& sender_ip, const std::string& digest) {
+    std::string sha256 = digest.empty() ? BlobStore::hashFile(staging_path) : digest;
+    if (sha256.empty()) {
+        std::cerr << "❌ Error al leer archivo: " << staging_path << " (" << strerror(errno) << ")" << std::endl;
+        return nullptr;
+    }
     
-    return ss.str();
+    // El staging vive en temp_dir: pasa a ser el blob sin copiar datos, o se
+    // descarta si ese contenido ya estaba guardado
+    std::string stored_name = makeStoredName(filename);
+    bool duplicate = false;
+    if (!blobs.adopt(staging_path, sha256, filesize, getFilePath(stored_name), duplicate)) {
+        return nullptr;
+    }
+    return publishFile(filename, stored_name, sha256, filesize, sender_ip, duplicate);
 }
 
-std::string FileManager::addTextMessage(const std::string& text, const std::string& sender_ip) {
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    Message msg;
-    msg.id = generateId();
-    msg.type = "text";
-    msg.content = text;
-    msg.timestamp = getCurrentTimestamp();
-    msg.sender_ip = sender_ip;
-    msg.filesize = 0;
-    
-    messages.push_back(msg);
-    
-    std::cout << "💬 Mensaje de texto agregado: " << msg.id << std::endl;
-    return msg.id;
+MessagePtr FileManager::addFileMessageFromBlob(const std::string& filename, const std::string& sha256, size_t filesize,
+                                               const std::string& sender_ip) {
+    std::string stored_name = makeStoredName(filename);
+    if (!blobs.link(sha256, filesize, getFilePath(stored_name))) {
+        return nullptr;
+    }
+    return publishFile(filename, stored_name, sha256, filesize, sender_ip, true);
 }
 
-std::string FileManager::addFileMessage(const std::string& filename, const std::string& file_data, const std::string& sender_ip) {
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // Guardar archivo en disco
-    std::string safe_filename = generateId() + "_" + filename;
-    std::string file_path = temp_dir + "/" + safe_filename;
+std::string FileManager::makeStoredName(const std::string& filename) {
+    return std::to_string(next_stored_id.fetch_add(1, std::memory_order_relaxed)) + "_" + filename;
+}
+
+MessagePtr FileManager::publishFile(const std::string& filename, const std::string& stored_name, const std::string& sha256,
+                                    size_t filesize, const std::string& sender_ip, bool duplicate) {
+    MessageDraft draft;
+    draft.type = MessageType::File;
+    draft.content = filename;  // nombre original
+    draft.filename = stored_name;
+    draft.sha256 = sha256;
+    draft.filesize = filesize;
+    draft.sender_ip = IpAddress::parse(sender_ip);
     
-    std::ofstream ofs(file_path, std::ios::binary);
-    if (!ofs) {
-        std::cerr << "❌ Error al crear archivo: " << file_path << std::endl;
-        return "";
+    auto msg = log.append(draft);
+    if (!msg) {
+        std::cerr << "❌ Historial lleno, archivo descartado: " << stored_name << std::endl;
+        blobs.release(sha256, getFilePath(stored_name));
+        return nullptr;
+    }
+    if (journal) {
+        journal->commit();
     }
     
-    ofs.write(file_data.data(), file_data.size());
-    ofs.close();
-    
-    Message msg;
-    msg.id = generateId();
-    msg.type = "file";
-    msg.filename = safe_filename;
-    msg.content = filename;  // nombre original
-    msg.filesize = file_data.size();
-    msg.timestamp = getCurrentTimestamp();
-    msg.sender_ip = sender_ip;
-    
-    messages.push_back(msg);
+    {
+        std::lock_guard<std::mutex> lock(files_mtx);
+        files[msg->seq] = {msg->id, stored_name, sha256, std::chrono::steady_clock::now()};
+        seq_by_filename[stored_name] = msg->seq;
+    }
     
-    std::cout << "📎 Archivo guardado: " << safe_filename << " (" << file_data.size() << " bytes)" << std::endl;
-    return msg.id;
+    if (duplicate) {
+        std::cout << "♻️  Archivo repetido, sin copia en disco: " << stored_name << " (" << filesize << " bytes)" << std::endl;
+    } else {
+        std::cout << "📎 Archivo guardado: " << stored_name << " (" << filesize << " bytes)" << std::endl;
+    }
+    return msg;
 }
 
-std::vector<Message> FileManager::getAllMessages() {
-    std::lock_guard<std::mutex> lock(mtx);
-    return messages;
+MessagePage FileManager::getMessagesSince(uint64_t since, size_t limit) {
+    return log.since(since, limit);
+}
+
+size_t FileManager::count() {
+    return log.size();
+}
+
+uint64_t FileManager::firstSeq() {
+    return log.first();
+}
+
+uint64_t FileManager::lastSeq() {
+    return log.last();
 }
 
 std::string FileManager::getFilePath(const std::string& filename) {
     return temp_dir + "/" + filename;
 }
 
-bool FileManager::fileExists(const std::string& filename) {
-    return fs::exists(getFilePath(filename));
+bool FileManager::touch(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(files_mtx);
+    auto it = seq_by_filename.find(filename);
+    if (it == seq_by_filename.end()) return false;
+    files[it->second].last_access = std::chrono::steady_clock::now();
+    return true;
+}
+
+FileManager::Eviction FileManager::enforceRetention(const RetentionLimits& limits) {
+    Eviction result;
+    uint64_t floor = log.first() - 1;
+    uint64_t last = log.last();
+    uint64_t target = floor;
+    
+    if (limits.max_messages > 0 && last - target > limits.max_messages) {
+        target = last - limits.max_messages;
+    }
+    
+    // Los mensajes están en orden de publicación: basta con recorrer el principio
+    if (limits.max_age_ms > 0) {
+        int64_t oldest_allowed = currentTimeMs() - limits.max_age_ms;
+        bool expired = true;
+        while (expired) {
+            auto batch = log.since(target, 1024);
+            if (batch.empty()) break;
+            for (const auto& msg : batch) {
+                if (msg->timestamp_ms >= oldest_allowed) {
+                    expired = false;
+                    break;
+                }
+                target = msg->seq;
+            }
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(files_mtx);
+        uint64_t stored = blobs.stats().bytes_stored;
+        
+        // Borra el archivo de files[seq]; avanza el iterador
+        auto removeFile = [&](std::map<uint64_t, StoredFile>::iterator it) {
+            if (!it->second.evicted) {
+                uint64_t freed = blobs.release(it->second.sha256, getFilePath(it->second.filename));
+                stored -= std::min(stored, freed);
+                result.bytes_freed += freed;
+                result.files_removed++;
+            } else {
+                evicted_count--;
+            }
+            seq_by_filename.erase(it->second.filename);
+            return files.erase(it);
+        };
+        
+        // Incluye archivos publicados después de una pasada anterior que ya
+        // había recortado su seq
+        auto it = files.begin();
+        while (it != files.end() && it->first <= target) {
+            it = removeFile(it);
+        }
+        
+        if (limits.max_bytes > 0 && stored > limits.max_bytes) {
+            if (!limits.evict_least_downloaded) {
+                while (it != files.end() && stored > limits.max_bytes) {
+                    target = it->first;
+                    it = removeFile(it);
+                }
+            } else {
+                std::vector<std::map<uint64_t, StoredFile>::iterator> candidates;
+                for (auto c = files.begin(); c != files.end(); ++c) {
+                    if (!c->second.evicted) candidates.push_back(c);
+                }
+                std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+                    return a->second.last_access < b->second.last_access;
+                });
+                
+                // El mensaje se queda en el historial, marcado como sin contenido
+                for (auto& c : candidates) {
+                    if (stored <= limits.max_bytes) break;
+                    uint64_t freed = blobs.release(c->second.sha256, getFilePath(c->second.filename));
+                    stored -= std::min(stored, freed);
+                    result.bytes_freed += freed;
+                    result.files_removed++;
+                    c->second.evicted = true;
+                    evicted_count++;
+                    result.files.push_back(c->second.message_id);
+                    if (journal) journal->stageEvicted(c->first);
+                }
+            }
+        }
+    }
+    
+    // También libera segmentos recortados en pasadas anteriores
+    log.trim(target);
+    if (journal && (target > floor || !result.files.empty())) {
+        if (target > floor) journal->stageTrim(target);
+        journal->commit();
+    }
+    result.first_seq = target + 1;
+    result.messages_trimmed = target - floor;
+    return result;
+}
+
+std::vector<uint64_t> FileManager::evictedFiles() {
+    std::vector<uint64_t> ids;
+    std::lock_guard<std::mutex> lock(files_mtx);
+    if (evicted_count == 0) return ids;
+    ids.reserve(evicted_count);
+    for (const auto& entry : files) {
+        if (entry.second.evicted) ids.push_back(entry.second.message_id);
+    }
+    return ids;
+}
+
+bool FileManager::enablePersistence(uint64_t snapshot_bytes) {
+    auto started = std::chrono::steady_clock::now();
+    
+    auto recovering = std::make_unique<MessageJournal>();
+    MessageJournal::State state;
+    if (!recovering->open(temp_dir + "/.journal", state)) {
+        return false;
+    }
+    
+    // Índices de retención y enlaces a blobs de los archivos recuperados
+    std::unordered_set<uint64_t> evicted(state.evicted.begin(), state.evicted.end());
+    auto now = std::chrono::steady_clock::now();
+    auto restoreFile = [&](const Message& msg) {
+        if (msg.seq <= state.floor) return;
+        StoredFile& file = files[msg.seq];
+        file = {msg.id, std::string(msg.filename()), std::string(msg.sha256()), now};
+        // Un blob que ya no está (expulsión sin registrar por un crash) cuenta como expulsado
+        if (evicted.count(msg.seq) || !blobs.restoreLink(file.sha256, msg.filesize)) {
+            file.evicted = true;
+            evicted_count++;
+        }
+        seq_by_filename[file.filename] = msg.seq;
+    };
+    {
+        std::lock_guard<std::mutex> lock(files_mtx);
+        if (state.snapshot) state.snapshot->forEachFile(restoreFile);
+        for (const auto& msg : state.messages) {
+            if (msg.isFile()) restoreFile(msg);
+        }
+    }
+    size_t orphans = blobs.removeUnreferenced();
+    
+    size_t recovered = state.lastSeq() - state.floor;
+    log.restore(state.floor, std::move(state.snapshot), state.messages);
+    
+    journal = std::move(recovering);
+    persistent = true;
+    log.setJournal(journal.get());
+    journal->startSnapshots([this]() {
+        MessageJournal::SnapshotSource source;
+        source.floor = log.first() - 1;
+        source.messages = log.since(source.floor);
+        std::lock_guard<std::mutex> lock(files_mtx);
+        for (const auto& entry : files) {
+            if (entry.second.evicted && entry.first > source.floor) source.evicted.push_back(entry.first);
+        }
+        return source;
+    }, snapshot_bytes);
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    std::cout << "💾 Modo persistente: " << recovered << " mensajes en " << elapsed.count() << " ms";
+    if (orphans > 0) std::cout << ", " << orphans << " blob(s) huérfanos eliminados";
+    std::cout << std::endl;
+    return true;
 }
 
 void FileManager::cleanup() {
     std::lock_guard<std::mutex> lock(mtx);
     
-    if (fs::exists(temp_dir)) {
+    if (journal) {
+        // Snapshot final: el próximo arranque no tiene nada que reproducir
+        log.setJournal(nullptr);
+        journal->close();
+        journal.reset();
+    }
+    
+    if (persistent) {
+        std::cout << "💾 Historial y archivos conservados en " << temp_dir << std::endl;
+    } else if (fs::exists(temp_dir)) {
         std::cout << "🧹 Limpiando directorio temporal..." << std::endl;
         
         try {
@@ -137,6 +350,13 @@ void FileManager::cleanup() {
         }
     }
     
-    messages.clear();
+    log.clear();
+    blobs.clear();
+    {
+        std::lock_guard<std::mutex> files_lock(files_mtx);
+        files.clear();
+        seq_by_filename.clear();
+        evicted_count = 0;
+    }
     std::cout << "🗑️  Mensajes borrados de memoria" << std::endl;
 }
\ No newline at end of file
@@ -3,45 +3,117 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <sys/stat.h>
 #include <experimental/filesystem>
+#include "MessageLog.h"
+#include "BlobStore.h"
+#include "MessageJournal.h"
 
 namespace fs = std::experimental::filesystem;
 
-struct Message {
-    std::string id;
-    std::string type;  // "text" o "file"
-    std::string content;  // texto o nombre del archivo
-    std::string filename;  // solo para archivos
-    size_t filesize;  // solo para archivos
-    std::string timestamp;
-    std::string sender_ip;
-};
-
 class FileManager {
+public:
+    // Límites de retención (0 = sin límite); los aplica RetentionManager
+    struct RetentionLimits {
+        int64_t max_age_ms = 0;
+        uint64_t max_bytes = 0;       // disco ocupado por los blobs
+        size_t max_messages = 0;
+        // Al pasar de max_bytes: borrar los archivos menos descargados en lugar
+        // de recortar el historial desde el principio
+        bool evict_least_downloaded = false;
+    };
+
+    struct Eviction {
+        uint64_t first_seq = 1;           // mensaje más antiguo que queda
+        size_t messages_trimmed = 0;
+        size_t files_removed = 0;
+        uint64_t bytes_freed = 0;
+        std::vector<uint64_t> files;      // ids de archivos borrados cuyo mensaje sigue en el historial
+        bool empty() const { return messages_trimmed == 0 && files.empty(); }
+    };
+
 private:
+    // Archivo publicado, para la retención
+    struct StoredFile {
+        uint64_t message_id;
+        std::string filename;
+        std::string sha256;
+        std::chrono::steady_clock::time_point last_access;
+        bool evicted = false;  // contenido borrado, el mensaje sigue en el historial
+    };
+
     std::string temp_dir;
-    std::vector<Message> messages;
-    std::mutex mtx;
+    MessageLog log;  // lectores sin lock; ver MessageLog.h
+    BlobStore blobs;  // contenido de los archivos por SHA-256; ver BlobStore.h
+    std::mutex mtx;  // solo para cleanup()
+    std::unique_ptr<MessageJournal> journal;  // solo en modo persistente
+    bool persistent = false;
+    
+    std::mutex files_mtx;  // protege files, seq_by_filename y evicted_count
+    std::map<uint64_t, StoredFile> files;  // por seq: el primero es el más antiguo
+    std::unordered_map<std::string, uint64_t> seq_by_filename;
+    size_t evicted_count = 0;
+    
+    // Prefijo de los nombres en temp_dir: empieza en la hora de arranque con el
+    // formato de los ids de mensaje, así no repite nombres de una ejecución anterior
+    std::atomic<uint64_t> next_stored_id{0};
     
-    std::string generateId();
-    std::string getCurrentTimestamp();
     void ensureTempDirExists();
+    // Nombre único en temp_dir para el archivo de un mensaje
+    std::string makeStoredName(const std::string& filename);
+    // Publica el mensaje de un archivo ya enlazado al blob
+    MessagePtr publishFile(const std::string& filename, const std::string& stored_name, const std::string& sha256,
+                           size_t filesize, const std::string& sender_ip, bool duplicate);
     
 public:
     FileManager();
     ~FileManager();
     
-    // Gestión de mensajes
-    std::string addTextMessage(const std::string& text, const std::string& sender_ip);
-    std::string addFileMessage(const std::string& filename, const std::string& file_data, const std::string& sender_ip);
+    // Gestión de mensajes: devuelven el mensaje publicado, nullptr si falla
+    MessagePtr addTextMessage(const std::string& text, const std::string& sender_ip);
+    // Publica un archivo ya escrito en disco (staging dentro de temp_dir) sin volver a copiarlo.
+    // digest: SHA-256 calculado mientras llegaban los datos; si está vacío se lee el archivo.
+    MessagePtr addFileMessageFromStaging(const std::string& filename, const std::string& staging_path, size_t filesize,
+                                         const std::string& sender_ip, const std::string& digest = "");
+    // Publica un contenido que ya está en el almacén sin recibir ningún byte;
+    // nullptr si no existe un blob con ese SHA-256 y tamaño
+    MessagePtr addFileMessageFromBlob(const std::string& filename, const std::string& sha256, size_t filesize,
+                                      const std::string& sender_ip);
     
-    // Obtener datos
-    std::vector<Message> getAllMessages();
+    // Obtener datos: solo se copian punteros, nunca el historial completo, y sin
+    // bloquear a los escritores
+    // Mensajes con seq > since, como mucho limit (0 = sin límite)
+    MessagePage getMessagesSince(uint64_t since, size_t limit = 0);
+    size_t count();       // mensajes retenidos
+    uint64_t firstSeq();  // seq del mensaje retenido más antiguo
+    uint64_t lastSeq();   // seq del mensaje más reciente
     std::string getFilePath(const std::string& filename);
-    bool fileExists(const std::string& filename);
+    
+    BlobStore::Stats blobStats() { return blobs.stats(); }
+    
+    // Retención: una descarga cuenta como uso para evict_least_downloaded.
+    // false si filename no es el archivo de un mensaje retenido: temp_dir
+    // también tiene stagings y blobs que no se sirven
+    bool touch(const std::string& filename);
+    // Recorta el historial y borra archivos hasta cumplir los límites. Lo llama
+    // un solo hilo; los lectores del historial no se bloquean.
+    Eviction enforceRetention(const RetentionLimits& limits);
+    // Archivos ya borrados cuyo mensaje sigue en el historial
+    std::vector<uint64_t> evictedFiles();
+    
+    // Modo persistente: recupera el historial de temp_dir/.journal y lo sigue
+    // guardando; temp_dir ya no se borra al cerrar. false si no se puede abrir.
+    bool enablePersistence(uint64_t snapshot_bytes);
+    bool isPersistent() const { return persistent; }
+    MessageJournal::Stats journalStats() { return journal ? journal->stats() : MessageJournal::Stats{}; }
     
     // Limpieza
     void cleanup();
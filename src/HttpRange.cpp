@@ -0,0 +1,143 @@
+#include "HttpRange.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <strings.h>
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t");
+    if (a == std::string::npos) return "";
+    size_t b = s.find_last_not_of(" \t");
+    return s.substr(a, b - a + 1);
+}
+
+bool parseNumber(const std::string& s, size_t& out) {
+    if (s.empty() || s.size() > 19) return false;
+    size_t value = 0;
+    for (char c : s) {
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    out = value;
+    return true;
+}
+
+} // namespace
+
+namespace HttpRange {
+
+RangeRequest parse(const std::string& header, size_t file_size, std::vector<ByteRange>& ranges) {
+    ranges.clear();
+
+    std::string value = trim(header);
+    if (value.size() < 6 || strncasecmp(value.c_str(), "bytes=", 6) != 0) {
+        return RangeRequest::None;
+    }
+
+    size_t specs = 0;
+    size_t start = 6;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) comma = value.size();
+        std::string spec = trim(value.substr(start, comma - start));
+        start = comma + 1;
+
+        if (spec.empty()) continue;
+        if (++specs > MAX_RANGES) {
+            return RangeRequest::None;
+        }
+
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos) return RangeRequest::None;
+        std::string first_str = trim(spec.substr(0, dash));
+        std::string last_str = trim(spec.substr(dash + 1));
+
+        if (first_str.empty()) {
+            // Sufijo: los últimos N bytes
+            size_t suffix;
+            if (!parseNumber(last_str, suffix)) return RangeRequest::None;
+            if (suffix == 0 || file_size == 0) continue;
+            size_t first = suffix >= file_size ? 0 : file_size - suffix;
+            ranges.push_back({first, file_size - 1});
+            continue;
+        }
+
+        size_t first;
+        if (!parseNumber(first_str, first)) return RangeRequest::None;
+
+        size_t last = file_size > 0 ? file_size - 1 : 0;
+        if (!last_str.empty()) {
+            size_t requested_last;
+            if (!parseNumber(last_str, requested_last) || requested_last < first) return RangeRequest::None;
+            last = std::min(last, requested_last);
+        }
+
+        if (first >= file_size) continue;  // no satisfacible, pero los demás pueden serlo
+        ranges.push_back({first, last});
+    }
+
+    if (specs == 0) return RangeRequest::None;
+    if (ranges.empty()) return RangeRequest::Unsatisfiable;
+
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange& a, const ByteRange& b) {
+        return a.first < b.first;
+    });
+
+    std::vector<ByteRange> merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.first <= merged.back().last + 1) {
+            merged.back().last = std::max(merged.back().last, r.last);
+        } else {
+            merged.push_back(r);
+        }
+    }
+    ranges.swap(merged);
+    return RangeRequest::Satisfiable;
+}
+
+std::string makeETag(const struct stat& st) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "\"%llx-%llx%09lx-%llx\"",
+             static_cast<unsigned long long>(st.st_size),
+             static_cast<unsigned long long>(st.st_mtim.tv_sec),
+             static_cast<unsigned long>(st.st_mtim.tv_nsec),
+             static_cast<unsigned long long>(st.st_ino));
+    return buf;
+}
+
+std::string lastModified(const struct stat& st) {
+    std::tm tm_utc;
+    time_t mtime = st.st_mtim.tv_sec;
+    gmtime_r(&mtime, &tm_utc);
+
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+    return std::string(buf, n);
+}
+
+bool ifRangeMatches(const std::string& if_range, const std::string& etag, const std::string& last_modified) {
+    std::string value = trim(if_range);
+    if (value.empty()) return true;
+
+    // Las ETag débiles nunca sirven para If-Range (RFC 7233 §3.2)
+    if (value.compare(0, 2, "W/") == 0) return false;
+    if (value[0] == '"') return value == etag;
+    return value == last_modified;
+}
+
+std::string contentRange(const ByteRange& range, size_t file_size) {
+    return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(file_size);
+}
+
+std::string makeBoundary() {
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    char buf[40];
+    snprintf(buf, sizeof(buf), "autosync_%016llx", static_cast<unsigned long long>(gen()));
+    return buf;
+}
+
+} // namespace HttpRange
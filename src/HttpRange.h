@@ -0,0 +1,46 @@
+#ifndef HTTP_RANGE_H
+#define HTTP_RANGE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <sys/stat.h>
+
+// Rango de bytes inclusivo [first, last], como en Content-Range
+struct ByteRange {
+    size_t first;
+    size_t last;
+
+    size_t length() const { return last - first + 1; }
+};
+
+enum class RangeRequest {
+    None,           // sin Range (o inválido/ignorado): respuesta 200 completa
+    Satisfiable,    // 206 con los rangos devueltos
+    Unsatisfiable   // 416
+};
+
+namespace HttpRange {
+    // Máximo de rangos por petición; más que esto se sirve el archivo completo
+    constexpr size_t MAX_RANGES = 64;
+
+    // Analiza "bytes=0-99,200-,-500" (RFC 7233). Los rangos se ordenan y se
+    // fusionan los solapados o contiguos.
+    RangeRequest parse(const std::string& header, size_t file_size, std::vector<ByteRange>& ranges);
+
+    // ETag fuerte derivado de tamaño, mtime e inodo
+    std::string makeETag(const struct stat& st);
+
+    // Fecha HTTP (IMF-fixdate) de la última modificación
+    std::string lastModified(const struct stat& st);
+
+    // If-Range: true si el validador coincide y el Range debe respetarse
+    bool ifRangeMatches(const std::string& if_range, const std::string& etag, const std::string& last_modified);
+
+    std::string contentRange(const ByteRange& range, size_t file_size);
+
+    // Boundary aleatorio para multipart/byteranges
+    std::string makeBoundary();
+}
+
+#endif
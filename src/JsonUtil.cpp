@@ -0,0 +1,152 @@
+#include "JsonUtil.h"
+#include "MessageLog.h"
+
+namespace JsonUtil {
+
+void appendString(std::string& out, std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+
+    out.reserve(out.size() + value.size() + 2);
+    out += '"';
+
+    // Copiar por tramos: la mayoría de los mensajes no tiene nada que escapar
+    const char* data = value.data();
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.append(data + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xf];
+                break;
+        }
+    }
+    out.append(data + start, value.size() - start);
+    out += '"';
+}
+
+void appendMessage(std::string& out, const Message& msg) {
+    out += "{\"seq\":";
+    appendDecimal(out, msg.seq);
+    // id (< 2^53) y timestamp (epoch en ms) van como números: el cliente formatea la hora
+    out += ",\"id\":";
+    appendDecimal(out, msg.id);
+    out += ",\"type\":";
+    out += msg.isFile() ? "\"file\"" : "\"text\"";
+    out += ",\"content\":";
+    appendString(out, msg.content());
+    out += ",\"timestamp\":";
+    appendDecimal(out, static_cast<uint64_t>(msg.timestamp_ms));
+    // La IP nunca necesita escapes
+    out += ",\"sender_ip\":\"";
+    msg.sender_ip.appendTo(out);
+    out += '"';
+
+    if (msg.isFile()) {
+        out += ",\"filename\":";
+        appendString(out, msg.filename());
+        out += ",\"filesize\":";
+        appendDecimal(out, msg.filesize);
+    }
+
+    out += '}';
+}
+
+std::string serializeMessage(const Message& msg) {
+    std::string out;
+    out.reserve(160 + msg.stringsSize());
+    appendMessage(out, msg);
+    return out;
+}
+
+void Writer::separator() {
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+    uint64_t bit = uint64_t(1) << depth;
+    if (has_items & bit) out += ',';
+    has_items |= bit;
+}
+
+void Writer::open(char bracket) {
+    separator();
+    out += bracket;
+    depth++;
+    has_items &= ~(uint64_t(1) << depth);
+}
+
+void Writer::close(char bracket) {
+    out += bracket;
+    depth--;
+}
+
+Writer& Writer::key(std::string_view name) {
+    separator();
+    out += '"';
+    out += name;
+    out += "\":";
+    after_key = true;
+    return *this;
+}
+
+Writer& Writer::value(std::string_view text) {
+    separator();
+    appendString(out, text);
+    return *this;
+}
+
+Writer& Writer::value(bool flag) {
+    separator();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+Writer& Writer::unsignedValue(uint64_t number) {
+    separator();
+    appendDecimal(out, number);
+    return *this;
+}
+
+Writer& Writer::signedValue(int64_t number) {
+    separator();
+    if (number < 0) {
+        out += '-';
+        appendDecimal(out, 0 - static_cast<uint64_t>(number));
+    } else {
+        appendDecimal(out, static_cast<uint64_t>(number));
+    }
+    return *this;
+}
+
+Writer& Writer::value(const Message& msg) {
+    separator();
+    appendMessage(out, msg);
+    return *this;
+}
+
+Writer& Writer::messages(const MessagePage& list) {
+    size_t total = out.size() + 2;
+    for (const auto& msg : list) total += 160 + msg->stringsSize();
+    out.reserve(total);
+
+    beginArray();
+    for (const auto& msg : list) {
+        value(*msg);
+    }
+    return endArray();
+}
+
+} // namespace JsonUtil
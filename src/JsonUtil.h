@@ -0,0 +1,69 @@
+#ifndef JSON_UTIL_H
+#define JSON_UTIL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+
+struct Message;
+class MessagePage;
+
+namespace JsonUtil {
+    // Añade value como string JSON (con comillas), escapando como crow::json
+    void appendString(std::string& out, std::string_view value);
+
+    // {"seq":..,"id":..,...}: mismos campos que se enviaban con crow::json::wvalue,
+    // con id y timestamp (epoch en ms) numéricos
+    void appendMessage(std::string& out, const Message& msg);
+    std::string serializeMessage(const Message& msg);
+
+    // JSON en streaming para las respuestas: escribe directamente en un solo
+    // buffer, sin el árbol de nodos (un map y sus strings por nodo) que construye
+    // crow::json::wvalue. Las comas las pone el escritor; los nombres de los
+    // campos no se escapan (son siempre literales nuestros).
+    class Writer {
+    public:
+        explicit Writer(size_t reserve = 256) { out.reserve(reserve); }
+
+        Writer& beginObject() { open('{'); return *this; }
+        Writer& endObject() { close('}'); return *this; }
+        Writer& beginArray() { open('['); return *this; }
+        Writer& endArray() { close(']'); return *this; }
+        Writer& key(std::string_view name);
+
+        Writer& value(std::string_view text);
+        Writer& value(const char* text) { return value(std::string_view(text)); }
+        Writer& value(const std::string& text) { return value(std::string_view(text)); }
+        Writer& value(bool flag);
+        template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        Writer& value(T number) {
+            if constexpr (std::is_signed_v<T>) {
+                return signedValue(number);
+            } else {
+                return unsignedValue(number);
+            }
+        }
+        Writer& value(const Message& msg);
+        // [msg1,msg2,...], reservando antes lo que van a ocupar
+        Writer& messages(const MessagePage& list);
+
+        std::string take() { return std::move(out); }
+
+    private:
+        std::string out;
+        uint64_t has_items = 0;  // un bit por nivel abierto: ¿hace falta coma?
+        int depth = 0;
+        bool after_key = false;
+
+        void separator();
+        void open(char bracket);
+        void close(char bracket);
+        Writer& unsignedValue(uint64_t number);
+        Writer& signedValue(int64_t number);
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "Message.h"
+#include <cstring>
+#include <charconv>
+#include <arpa/inet.h>
+
+IpAddress IpAddress::parse(std::string_view text) {
+    IpAddress ip;
+
+    size_t comma = text.find(',');
+    if (comma != std::string_view::npos) text = text.substr(0, comma);
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+
+    char buffer[INET6_ADDRSTRLEN];
+    if (text.empty() || text.size() >= sizeof(buffer)) return ip;
+    memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    if (inet_pton(AF_INET6, buffer, ip.bytes.data()) == 1) return ip;
+    if (inet_pton(AF_INET, buffer, ip.bytes.data() + 12) == 1) {
+        ip.bytes[10] = 0xff;
+        ip.bytes[11] = 0xff;
+        return ip;
+    }
+    return IpAddress();
+}
+
+void IpAddress::appendTo(std::string& out) const {
+    static const uint8_t v4_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    static const uint8_t zero[16] = {};
+
+    if (memcmp(bytes.data(), v4_prefix, 12) == 0) {
+        // El caso de casi todos los mensajes: sin inet_ntop y con un solo append
+        char buffer[16];
+        size_t n = 0;
+        for (int i = 12; i < 16; i++) {
+            uint8_t octet = bytes[i];
+            if (i > 12) buffer[n++] = '.';
+            if (octet >= 100) buffer[n++] = static_cast<char>('0' + octet / 100);
+            if (octet >= 10) buffer[n++] = static_cast<char>('0' + octet / 10 % 10);
+            buffer[n++] = static_cast<char>('0' + octet % 10);
+        }
+        out.append(buffer, n);
+        return;
+    }
+    if (memcmp(bytes.data(), zero, 16) == 0) return;
+
+    char buffer[INET6_ADDRSTRLEN];
+    if (inet_ntop(AF_INET6, bytes.data(), buffer, sizeof(buffer))) {
+        out += buffer;
+    }
+}
+
+std::string IpAddress::toString() const {
+    std::string out;
+    appendTo(out);
+    return out;
+}
+
+void appendDecimal(std::string& out, uint64_t value) {
+    char buffer[20];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
@@ -0,0 +1,92 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+enum class MessageType : uint8_t {
+    Text = 0,
+    File = 1
+};
+
+// IP del remitente en 16 bytes: IPv6, o IPv4 como ::ffff:a.b.c.d
+struct IpAddress {
+    std::array<uint8_t, 16> bytes{};
+
+    // Todo ceros si text no es una IP; de una lista (X-Forwarded-For) vale la primera
+    static IpAddress parse(std::string_view text);
+    // Forma textual (IPv4 con puntos); vacía si no se conoce
+    void appendTo(std::string& out) const;
+    std::string toString() const;
+};
+
+// Mensaje del historial en 64 bytes. Las cadenas (content, filename y sha256,
+// seguidas) no son del mensaje: viven en el segmento de MessageLog que lo
+// contiene o en el snapshot mapeado en memoria, así que un Message solo es
+// válido mientras algo mantenga vivo ese segmento (MessagePtr o MessagePage).
+struct Message {
+    uint64_t seq = 0;           // posición en el historial (1, 2, 3...), estable y creciente
+    uint64_t id = 0;            // único y creciente con seq; ver MessageLog::append
+    int64_t timestamp_ms = 0;   // epoch en ms
+    uint64_t filesize = 0;      // solo para archivos
+    const char* strings = nullptr;
+    uint32_t content_size = 0;
+    uint16_t filename_size = 0;
+    uint8_t sha256_size = 0;
+    MessageType type = MessageType::Text;
+    IpAddress sender_ip;
+
+    bool isFile() const { return type == MessageType::File; }
+    // Texto o nombre original del archivo
+    std::string_view content() const { return {strings, content_size}; }
+    // Nombre en temp_dir (solo archivos)
+    std::string_view filename() const { return {strings + content_size, filename_size}; }
+    // Blob del contenido en BlobStore (solo archivos)
+    std::string_view sha256() const { return {strings + content_size + filename_size, sha256_size}; }
+    size_t stringsSize() const { return size_t(content_size) + filename_size + sha256_size; }
+};
+
+class MessageLog;
+
+// Mensajes leídos del historial (MessageLog::since). Se recorre como un vector
+// de const Message*; la página mantiene vivos sus segmentos con una referencia
+// por segmento, no una por mensaje, y los punteros valen mientras ella viva.
+class MessagePage {
+public:
+    using const_iterator = std::vector<const Message*>::const_iterator;
+
+    const_iterator begin() const { return messages.begin(); }
+    const_iterator end() const { return messages.end(); }
+    size_t size() const { return messages.size(); }
+    bool empty() const { return messages.empty(); }
+    const Message* operator[](size_t index) const { return messages[index]; }
+    const Message* back() const { return messages.back(); }
+    void clear() {
+        messages.clear();
+        owners.clear();
+    }
+
+private:
+    friend class MessageLog;
+    std::vector<std::shared_ptr<const void>> owners;
+    std::vector<const Message*> messages;
+};
+
+// Lo que aporta quien publica; seq, id y timestamp los pone MessageLog::append
+struct MessageDraft {
+    MessageType type = MessageType::Text;
+    std::string_view content;
+    std::string_view filename;
+    std::string_view sha256;
+    uint64_t filesize = 0;
+    IpAddress sender_ip;
+};
+
+// Entero en decimal sin pasar por std::to_string
+void appendDecimal(std::string& out, uint64_t value);
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef MESSAGE_JOURNAL_H
+#define MESSAGE_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include "MessageLog.h"
+
+// Historial persistente: un journal append-only de registros con CRC32 y
+// snapshots periódicos del estado completo.
+//
+//   registro = u32 largo, u32 crc32 del payload, payload
+//   payload  = u8 tipo, campos (varints LEB128 y cadenas con su largo delante)
+//     1 mensaje:  seq, timestamp_ms, u8 tipo, id, filesize, 16 bytes de IP,
+//                 largos de content, filename y sha256, y las tres cadenas seguidas
+//     2 recorte:  seq más reciente eliminado (MessageLog::trim)
+//     3 expulsión: seq de un archivo borrado cuyo mensaje sigue (retención lru)
+//
+//   snapshot = "ASSNAP02", u64 suelo, u64 n mensajes, u64 n expulsados,
+//              u32 crc32 del resto, n × u64 seq expulsado, n × registro de mensaje
+//              (seq consecutivos desde suelo + 1)
+//
+// Los escritores preparan su registro en memoria (stage*) y commit() lo hace
+// durable: el primero que llega escribe y hace fdatasync de todo lo acumulado
+// mientras los demás esperan, así que N publicaciones simultáneas cuestan un
+// solo fdatasync. Al arrancar se mapea el snapshot con mmap y solo se reproduce
+// lo que el journal tenga detrás; un registro cortado por un crash se descarta.
+
+// Snapshot abierto con mmap. Al cargarlo solo se comprueba el CRC y se anota
+// dónde empieza cada tramo de mensajes; MessageLog los decodifica por segmentos
+// cuando se piden, así que arrancar no depende del tamaño del historial.
+class SnapshotImage {
+public:
+    static constexpr size_t CHECKPOINT = 1024;  // mensajes entre offsets anotados
+
+    // nullptr si no existe, no es un snapshot o está dañado
+    static std::shared_ptr<const SnapshotImage> load(const std::string& path);
+    ~SnapshotImage();
+
+    uint64_t floor() const { return floor_seq; }
+    uint64_t firstSeq() const { return floor_seq + 1; }
+    uint64_t lastSeq() const { return floor_seq + count; }
+    size_t size() const { return count; }
+    const std::vector<uint64_t>& evicted() const { return evicted_seqs; }
+
+    // Escribe en out los mensajes con seq en [first, last], que deben estar
+    // dentro del snapshot. Sus cadenas apuntan al mapeo: la imagen tiene que
+    // seguir viva mientras se usen.
+    bool decode(uint64_t first, uint64_t last, Message* out) const;
+    // Recorre solo los mensajes de archivo (índices de retención y de blobs)
+    void forEachFile(const std::function<void(const Message&)>& fn) const;
+
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    uint64_t floor_seq = 0;
+    uint64_t count = 0;
+    std::vector<uint64_t> evicted_seqs;
+    std::vector<size_t> checkpoints;  // offset del mensaje i * CHECKPOINT
+
+    SnapshotImage() = default;
+};
+
+class MessageJournal {
+public:
+    struct State {
+        uint64_t floor = 0;                                // seq <= floor recortados
+        std::shared_ptr<const SnapshotImage> snapshot;     // nullptr si no había
+        std::vector<Message> messages;                     // journal detrás del snapshot
+        std::vector<uint64_t> evicted;
+        std::deque<std::string> journals;                  // contenido leído: cadenas de messages
+
+        uint64_t lastSeq() const;
+    };
+
+    struct SnapshotSource {
+        uint64_t floor;
+        MessagePage messages;
+        std::vector<uint64_t> evicted;
+    };
+    // Captura el estado en memoria para un snapshot; se llama desde el hilo de
+    // snapshots después de rotar el journal
+    using StateProvider = std::function<SnapshotSource()>;
+
+    struct Stats {
+        uint64_t records;   // escritos desde el arranque
+        uint64_t commits;   // fdatasync hechos
+        uint64_t journal_bytes;
+        uint64_t snapshots;
+    };
+
+    ~MessageJournal();
+
+    // Crea dir si no existe, recupera snapshot + journal en state y deja el
+    // journal abierto para añadir. false si no se puede escribir.
+    bool open(const std::string& dir, State& state);
+
+    // A partir de snapshot_bytes de journal se escribe un snapshot nuevo
+    void startSnapshots(StateProvider provider, uint64_t snapshot_bytes);
+
+    // Solo en memoria; los de mensajes se llaman en orden de seq
+    void stageMessage(const Message& msg);
+    void stageTrim(uint64_t floor);
+    void stageEvicted(uint64_t seq);
+    // Vuelve cuando todo lo preparado antes de llamar está en disco
+    void commit();
+
+    // Snapshot final (el próximo arranque no reproduce nada) y cierre
+    void close();
+    Stats stats();
+
+private:
+    std::string dir;
+    int fd = -1;
+
+    std::mutex mtx;
+    std::condition_variable durable_cv;
+    std::string pending;       // registros preparados sin escribir
+    uint64_t staged = 0;       // registros preparados (contador)
+    uint64_t durable = 0;      // registros ya en disco
+    bool flushing = false;     // hay un líder escribiendo
+    uint64_t journal_bytes = 0;
+    uint64_t commits = 0;
+    uint64_t snapshots = 0;
+
+    StateProvider provider;
+    uint64_t snapshot_bytes = 0;
+    std::thread snapshot_thread;
+    std::condition_variable snapshot_cv;
+    bool snapshot_requested = false;
+    bool stopping = false;
+
+    std::string journalPath() const { return dir + "/journal"; }
+    std::string previousPath() const { return dir + "/journal.prev"; }
+    std::string snapshotPath() const { return dir + "/snapshot"; }
+
+    void stage(const std::string& payload);
+    void snapshotLoop();
+    bool takeSnapshot();
+    bool writeSnapshot(const SnapshotSource& source);
+    // Abre un journal vacío; el anterior pasa a journal.prev hasta que el
+    // snapshot que lo contiene esté en disco. Con mtx tomado y sin líder.
+    bool rotateLocked();
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "MessageLog.h"
+#include "MessageJournal.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+MessageLog::MessageLog()
+    : segments(new Entry[MAX_SEGMENTS]) {}
+
+MessageLog::~MessageLog() {
+    clear();
+}
+
+MessagePtr MessageLog::append(const MessageDraft& draft) {
+    if (draft.content.size() > UINT32_MAX || draft.filename.size() > UINT16_MAX || draft.sha256.size() > UINT8_MAX) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(append_mtx);
+
+    uint64_t position = published.load(std::memory_order_relaxed);
+    size_t segment_index = position / SEGMENT_SIZE;
+    if (segment_index >= MAX_SEGMENTS) {
+        return nullptr;
+    }
+
+    // trim nunca suelta el segmento en el que se está escribiendo: solo los que
+    // quedan enteros por debajo de `published`
+    if (!segments[segment_index].segment.load(std::memory_order_relaxed)) {
+        // Los lectores solo llegan a este segmento después de ver `published`
+        createSegment(segment_index);
+    }
+    std::shared_ptr<Segment> segment = segments[segment_index].owner;
+
+    Message& msg = segment->slots[position % SEGMENT_SIZE];
+    msg.seq = position + 1;
+    msg.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Creciente aunque el reloj retroceda o lleguen más de 4096 mensajes en un ms
+    last_id = std::max(last_id + 1, static_cast<uint64_t>(msg.timestamp_ms - ID_EPOCH_MS) << ID_SEQUENCE_BITS);
+    msg.id = last_id;
+    msg.type = draft.type;
+    msg.filesize = draft.filesize;
+    msg.sender_ip = draft.sender_ip;
+    msg.content_size = static_cast<uint32_t>(draft.content.size());
+    msg.filename_size = static_cast<uint16_t>(draft.filename.size());
+    msg.sha256_size = static_cast<uint8_t>(draft.sha256.size());
+
+    char* strings = static_cast<char*>(segment->arena.allocate(std::max<size_t>(msg.stringsSize(), 1), 1));
+    memcpy(strings, draft.content.data(), draft.content.size());
+    memcpy(strings + msg.content_size, draft.filename.data(), draft.filename.size());
+    memcpy(strings + msg.content_size + msg.filename_size, draft.sha256.data(), draft.sha256.size());
+    msg.strings = strings;
+
+    if (journal) {
+        journal->stageMessage(msg);
+    }
+
+    // A partir de aquí el slot es visible y ya no se modifica
+    published.store(position + 1, std::memory_order_release);
+    return MessagePtr(std::move(segment), &msg);
+}
+
+void MessageLog::setJournal(MessageJournal* new_journal) {
+    std::lock_guard<std::mutex> lock(append_mtx);
+    journal = new_journal;
+}
+
+MessageLog::Segment* MessageLog::createSegment(size_t index) const {
+    auto segment = std::make_shared<Segment>();
+    Segment* raw = segment.get();
+    publishSegment(index, std::move(segment));
+    return raw;
+}
+
+void MessageLog::publishSegment(size_t index, std::shared_ptr<Segment> segment) const {
+    Entry& entry = segments[index];
+    Segment* raw = segment.get();
+    entry.owner = std::move(segment);
+    // owner (y los slots) quedan escritos antes de que un lector vea el puntero
+    entry.segment.store(raw, std::memory_order_seq_cst);
+}
+
+void MessageLog::releaseSegment(size_t index) const {
+    Entry& entry = segments[index];
+    if (!entry.segment.load(std::memory_order_relaxed)) return;
+    entry.segment.store(nullptr, std::memory_order_seq_cst);
+    // Un lector que marcó la entrada antes de este store puede estar copiando
+    // owner: solo dura lo que una copia de shared_ptr
+    while (entry.pins.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    entry.owner.reset();
+}
+
+void MessageLog::store(Segment& segment, const Message& msg) {
+    Message& slot = segment.slots[(msg.seq - 1) % SEGMENT_SIZE];
+    slot = msg;
+    char* strings = static_cast<char*>(segment.arena.allocate(std::max<size_t>(msg.stringsSize(), 1), 1));
+    memcpy(strings, msg.strings, msg.stringsSize());
+    slot.strings = strings;
+}
+
+void MessageLog::restore(uint64_t floor, std::shared_ptr<const SnapshotImage> snapshot,
+                         const std::vector<Message>& tail) {
+    std::lock_guard<std::mutex> lock(append_mtx);
+    std::lock_guard<std::mutex> trim_lock(trim_mtx);
+
+    uint64_t last = tail.empty() ? floor : tail.back().seq;
+    if (snapshot && snapshot->lastSeq() > floor) {
+        std::lock_guard<std::mutex> load_lock(load_mtx);
+        image = std::move(snapshot);
+        lazy_first = std::max(floor + 1, image->firstSeq());
+        lazy_last = image->lastSeq();
+        lazy_begin = (lazy_first - 1) / SEGMENT_SIZE;
+        lazy_end = (lazy_last - 1) / SEGMENT_SIZE + 1;
+        if (tail.empty()) last = lazy_last;
+    }
+
+    // El último segmento del snapshot se carga ya: el journal y los append
+    // siguen llenándolo
+    if (lazy_end > lazy_begin) loadSegment(lazy_end - 1);
+
+    for (const auto& msg : tail) {
+        size_t index = (msg.seq - 1) / SEGMENT_SIZE;
+        Segment* segment = segments[index].segment.load(std::memory_order_relaxed);
+        if (!segment) segment = createSegment(index);
+        store(*segment, msg);
+        last_id = std::max(last_id, msg.id);
+    }
+    if (lazy_end > lazy_begin) {
+        Segment* segment = segments[lazy_end - 1].segment.load(std::memory_order_relaxed);
+        last_id = std::max(last_id, segment->slots[(lazy_last - 1) % SEGMENT_SIZE].id);
+    }
+
+    trimmed.store(floor, std::memory_order_release);
+    published.store(last, std::memory_order_release);
+}
+
+std::shared_ptr<MessageLog::Segment> MessageLog::loadSegment(size_t index) const {
+    std::lock_guard<std::mutex> lock(load_mtx);
+    // trim sube lazy_begin con este lock: un segmento ya recortado no se carga
+    if (segments[index].segment.load(std::memory_order_acquire)) {
+        return segments[index].owner;
+    }
+    if (!image || index < lazy_begin || index >= lazy_end) {
+        return nullptr;
+    }
+
+    uint64_t first = std::max<uint64_t>(lazy_first, index * SEGMENT_SIZE + 1);
+    uint64_t last = std::min<uint64_t>(lazy_last, (index + 1) * SEGMENT_SIZE);
+
+    auto segment = std::make_shared<Segment>();
+    segment->image = image;
+    image->decode(first, last, segment->slots.data() + (first - 1) % SEGMENT_SIZE);
+    publishSegment(index, segment);
+    return segment;
+}
+
+std::shared_ptr<MessageLog::Segment> MessageLog::segmentAt(size_t index) const {
+    Entry& entry = segments[index];
+    std::shared_ptr<Segment> segment;
+    // La marca va antes de mirar el puntero: si trim lo vació después, espera
+    // a que la quitemos antes de soltar owner
+    entry.pins.fetch_add(1, std::memory_order_seq_cst);
+    if (entry.segment.load(std::memory_order_seq_cst)) {
+        segment = entry.owner;
+    }
+    entry.pins.fetch_sub(1, std::memory_order_release);
+    return segment ? segment : loadSegment(index);
+}
+
+MessagePage MessageLog::since(uint64_t seq, size_t limit) const {
+    uint64_t floor = trimmed.load(std::memory_order_acquire);
+    if (seq < floor) seq = floor;
+    uint64_t last = published.load(std::memory_order_acquire);
+
+    MessagePage page;
+    if (seq >= last) return page;
+
+    uint64_t count = last - seq;
+    if (limit > 0 && count > limit) count = limit;
+    page.messages.reserve(count);
+
+    // Una referencia por segmento: los mensajes son punteros a sus slots
+    uint64_t end = seq + count;
+    for (uint64_t position = seq; position < end;) {
+        size_t segment_index = position / SEGMENT_SIZE;
+        uint64_t segment_end = std::min<uint64_t>(end, (segment_index + 1) * SEGMENT_SIZE);
+        std::shared_ptr<Segment> segment = segmentAt(segment_index);
+        // Recortado mientras se leía: esos mensajes ya no existen
+        if (segment) {
+            for (size_t slot = position % SEGMENT_SIZE; position < segment_end; position++, slot++) {
+                const Message& msg = segment->slots[slot];
+                if (msg.seq != 0) page.messages.push_back(&msg);
+            }
+            page.owners.push_back(std::move(segment));
+        }
+        position = segment_end;
+    }
+    return page;
+}
+
+void MessageLog::trim(uint64_t up_to) {
+    std::lock_guard<std::mutex> lock(trim_mtx);
+
+    uint64_t floor = trimmed.load(std::memory_order_relaxed);
+    uint64_t last = published.load(std::memory_order_acquire);
+    if (up_to > last) up_to = last;
+    if (up_to <= floor) return;
+
+    trimmed.store(up_to, std::memory_order_release);
+
+    // Segmentos enteros por debajo del suelo: el último MessagePtr o MessagePage que quede los libera.
+    // Un segmento del snapshot no cargado no tiene nada que soltar, y ya no se cargará
+    std::lock_guard<std::mutex> load_lock(load_mtx);
+    for (size_t i = floor / SEGMENT_SIZE; (i + 1) * SEGMENT_SIZE <= up_to; i++) {
+        releaseSegment(i);
+        if (i >= lazy_begin && i < lazy_end) lazy_begin = i + 1;
+    }
+}
+
+void MessageLog::clear() {
+    std::lock_guard<std::mutex> lock(append_mtx);
+    std::lock_guard<std::mutex> trim_lock(trim_mtx);
+    std::lock_guard<std::mutex> load_lock(load_mtx);
+    published.store(0, std::memory_order_release);
+    trimmed.store(0, std::memory_order_release);
+    image.reset();
+    lazy_begin = lazy_end = 0;
+    last_id = 0;
+
+    for (size_t i = 0; i < MAX_SEGMENTS; i++) {
+        releaseSegment(i);
+    }
+}
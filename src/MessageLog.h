@@ -0,0 +1,136 @@
+#ifndef MESSAGE_LOG_H
+#define MESSAGE_LOG_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Message.h"
+
+// Los mensajes publicados no cambian. Un MessagePtr comparte la propiedad del
+// segmento que contiene el mensaje (y sus cadenas): no hay una reserva por mensaje.
+using MessagePtr = std::shared_ptr<const Message>;
+
+class MessageJournal;
+class SnapshotImage;
+
+// Historial append-only en segmentos de tamaño fijo.
+//
+// Un slot se escribe una sola vez y después se publica subiendo `published`
+// (release); los lectores cargan `published` (acquire) y leen los slots por
+// debajo sin tomar el lock de los escritores. El directorio es un array fijo
+// de entradas con un Segment* atómico y el shared_ptr que lo posee: crecer no
+// mueve nada que un lector pueda estar leyendo, y leer no toma ningún lock.
+//
+// Cada segmento guarda sus mensajes por valor (Message ocupa 64 bytes) y las
+// cadenas en una arena propia, así que un mensaje cuesta 64 bytes más su texto.
+// JSON y protocolo binario se generan al enviar.
+//
+// La retención recorta el principio con trim(): el historial suelta en el acto
+// los segmentos que quedan por debajo del suelo. Un lector copia el shared_ptr
+// del segmento antes de tocar sus slots (una vez por segmento): marca la entrada
+// en `pins`, comprueba el puntero y solo entonces copia `owner`; trim vacía el
+// puntero y espera a que no quede ninguna marca antes de soltar `owner`. Lo que
+// el lector ya tiene en la mano sigue vivo hasta que suelte su MessagePage; si
+// llega tarde encuentra la entrada vacía y se salta esos mensajes, que ya
+// estaban recortados.
+//
+// Al arrancar en modo persistente los segmentos del snapshot no se decodifican:
+// el primer lector que llega a uno lo carga (una vez, bajo load_mtx) con las
+// cadenas apuntando al snapshot mapeado en memoria, sin copiarlas.
+class MessageLog {
+public:
+    static constexpr size_t SEGMENT_SIZE = 1024;
+    static constexpr size_t MAX_SEGMENTS = 64 * 1024;  // 64M mensajes
+    // id = ms desde ID_EPOCH_MS << ID_SEQUENCE_BITS | secuencia: cabe en los
+    // 53 bits de un Number de JS hasta ~2093
+    static constexpr int64_t ID_EPOCH_MS = 1704067200000;  // 2024-01-01 UTC
+    static constexpr int ID_SEQUENCE_BITS = 12;
+
+    MessageLog();
+    ~MessageLog();
+
+    // Asigna seq, id y timestamp, copia las cadenas al segmento y publica;
+    // nullptr si el historial está lleno. Los escritores se serializan entre
+    // sí, nunca con los lectores.
+    MessagePtr append(const MessageDraft& draft);
+
+    // Modo persistente: cada append prepara su registro en el journal en orden
+    // de seq (el llamador hace commit() fuera del lock)
+    void setJournal(MessageJournal* journal);
+
+    // Arranque, con el historial vacío: los mensajes del snapshot (se cargan
+    // bajo demanda) y detrás los del journal, con seq consecutivos desde floor + 1.
+    // Las cadenas de tail se copian.
+    void restore(uint64_t floor, std::shared_ptr<const SnapshotImage> snapshot,
+                 const std::vector<Message>& tail);
+
+    // Mensajes con seq > since, como mucho limit (0 = sin límite)
+    MessagePage since(uint64_t seq, size_t limit = 0) const;
+    // Mensajes retenidos; el seq más antiguo es first() y el más reciente last()
+    size_t size() const { return last() - (first() - 1); }
+    uint64_t first() const { return trimmed.load(std::memory_order_acquire) + 1; }
+    uint64_t last() const { return published.load(std::memory_order_acquire); }
+
+    // Descarta los mensajes con seq <= up_to (solo avanza, nunca retrocede) y
+    // suelta los segmentos que quedan enteros por debajo
+    void trim(uint64_t up_to);
+
+    // Solo con el servidor parado
+    void clear();
+
+private:
+    struct Segment {
+        std::array<Message, SEGMENT_SIZE> slots;  // seq == 0: vacío
+        std::pmr::monotonic_buffer_resource arena{16 * 1024};  // cadenas de los append
+        std::shared_ptr<const SnapshotImage> image;  // cadenas de los cargados del snapshot
+    };
+
+    // Entrada del directorio. owner solo se escribe con `segment` a nullptr y
+    // sin marcas (con append_mtx, trim_mtx o load_mtx: cada segmento con uno solo);
+    // los lectores solo lo copian con la entrada marcada y `segment` no nulo
+    struct Entry {
+        std::atomic<Segment*> segment{nullptr};
+        std::atomic<uint32_t> pins{0};
+        std::shared_ptr<Segment> owner;
+    };
+
+    std::unique_ptr<Entry[]> segments;  // MAX_SEGMENTS entradas
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> trimmed{0};  // seq <= trimmed ya no existen para los lectores
+    std::mutex append_mtx;
+    uint64_t last_id = 0;
+    MessageJournal* journal = nullptr;
+
+    std::mutex trim_mtx;
+
+    // Carga diferida del snapshot: segmentos [lazy_begin, lazy_end) con los
+    // seq [lazy_first, lazy_last]
+    mutable std::mutex load_mtx;
+    std::shared_ptr<const SnapshotImage> image;
+    uint64_t lazy_first = 0;
+    uint64_t lazy_last = 0;
+    size_t lazy_begin = 0;
+    size_t lazy_end = 0;
+
+    // Propiedad del segmento index; lo carga del snapshot si hace falta.
+    // nullptr si no existe o ya se recortó
+    std::shared_ptr<Segment> segmentAt(size_t index) const;
+    // Crea el segmento index vacío (con el lock que corresponda tomado)
+    Segment* createSegment(size_t index) const;
+    // Publica segment en la entrada vacía index
+    void publishSegment(size_t index, std::shared_ptr<Segment> segment) const;
+    // Vacía la entrada index; el segmento vive mientras queden MessagePtr o MessagePage suyos
+    void releaseSegment(size_t index) const;
+    // Decodifica el segmento del snapshot si aún no está; nullptr si no es de él
+    std::shared_ptr<Segment> loadSegment(size_t index) const;
+    // Copia msg (ya con seq) y sus cadenas al slot que le toca
+    static void store(Segment& segment, const Message& msg);
+};
+
+#endif
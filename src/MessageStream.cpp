@@ -0,0 +1,118 @@
+#include "MessageStream.h"
+#include "FileManager.h"
+#include "JsonUtil.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr size_t BATCH = 256;       // mensajes por lectura del historial
+constexpr size_t SIZE_DIGITS = 8;   // largo de cada trozo en hex, con ceros a la izquierda
+
+// Un envío en curso. Se mantiene vivo con el shared_ptr capturado en la
+// escritura pendiente del io_context.
+class ChunkedMessages : public std::enable_shared_from_this<ChunkedMessages> {
+public:
+    ChunkedMessages(boost::asio::ip::tcp::socket& socket, FileManager& files,
+                    uint64_t since, uint64_t last, MessageStream::Done done)
+        : socket(socket), files(files), cursor(since), last(last), done(std::move(done)) {}
+
+    void start() {
+        buffer.reserve(MessageStream::CHUNK_BYTES + 4096);
+        step();
+    }
+
+private:
+    boost::asio::ip::tcp::socket& socket;
+    FileManager& files;
+    uint64_t cursor;  // seq del último mensaje enviado
+    uint64_t last;
+    MessageStream::Done done;
+
+    std::string buffer;  // trozo en vuelo, se reutiliza
+    MessagePage batch;
+    size_t batch_pos = 0;
+    size_t sent = 0;
+    bool opened = false;
+    bool closed = false;
+
+    void step() {
+        if (closed) {
+            finish(true);
+            return;
+        }
+
+        // El largo del trozo se escribe al final sobre este hueco: sin copiar los datos
+        buffer.assign(SIZE_DIGITS, '0');
+        buffer += "\r\n";
+        if (!opened) {
+            buffer += "{\"messages\":[";
+            opened = true;
+        }
+
+        while (buffer.size() < MessageStream::CHUNK_BYTES) {
+            if (batch_pos == batch.size()) {
+                batch.clear();
+                batch_pos = 0;
+                if (cursor < last) {
+                    batch = files.getMessagesSince(cursor, std::min<uint64_t>(BATCH, last - cursor));
+                }
+                // También si la retención recortó lo que quedaba por enviar
+                if (batch.empty()) {
+                    closeDocument();
+                    break;
+                }
+            }
+
+            const Message& msg = *batch[batch_pos++];
+            if (sent++ > 0) buffer += ',';
+            JsonUtil::appendMessage(buffer, msg);
+            cursor = msg.seq;
+        }
+
+        static const char hex[] = "0123456789abcdef";
+        size_t size = buffer.size() - SIZE_DIGITS - 2;
+        for (size_t i = SIZE_DIGITS; i > 0; i--, size >>= 4) {
+            buffer[i - 1] = hex[size & 0xf];
+        }
+        buffer += "\r\n";
+        if (closed) {
+            buffer += "0\r\n\r\n";
+        }
+
+        auto self = shared_from_this();
+        boost::asio::async_write(socket, boost::asio::buffer(buffer),
+                                 [self](const boost::system::error_code& ec, std::size_t) {
+                                     if (ec) {
+                                         self->finish(false);
+                                     } else {
+                                         self->step();
+                                     }
+                                 });
+    }
+
+    void closeDocument() {
+        buffer += "],\"next_since\":";
+        appendDecimal(buffer, cursor);
+        buffer += ",\"has_more\":";
+        buffer += cursor < files.lastSeq() ? "true" : "false";
+        buffer += '}';
+        closed = true;
+    }
+
+    void finish(bool ok) {
+        if (done) {
+            auto callback = std::move(done);
+            done = nullptr;
+            callback(ok);
+        }
+    }
+};
+
+} // namespace
+
+void MessageStream::send(boost::asio::ip::tcp::socket& socket, FileManager& files,
+                         uint64_t since, uint64_t last, Done done) {
+    std::make_shared<ChunkedMessages>(socket, files, since, last, std::move(done))->start();
+}
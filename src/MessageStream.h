@@ -0,0 +1,31 @@
+#ifndef MESSAGE_STREAM_H
+#define MESSAGE_STREAM_H
+
+#include <cstdint>
+#include <functional>
+#include <boost/asio.hpp>
+
+class FileManager;
+
+// Respuesta de /api/messages en streaming (Transfer-Encoding: chunked).
+//
+// Los mensajes se leen del historial por lotes y se serializan en un buffer
+// de tamaño fijo que se envía como un trozo; cuando el socket lo acepta se
+// llena el siguiente. La memoria no depende de cuántos mensajes se pidan y el
+// primer trozo sale sin esperar a serializar el resto. Como DownloadEngine,
+// corre sobre el io_context de la conexión sin ocupar el worker.
+class MessageStream {
+public:
+    using Done = std::function<void(bool ok)>;
+
+    // Por debajo de esto una respuesta normal (un buffer con Content-Length) sale más barata
+    static constexpr size_t MIN_MESSAGES = 1024;
+    static constexpr size_t CHUNK_BYTES = 64 * 1024;
+
+    // Escribe {"messages":[...],"next_since":N,"has_more":b} con los mensajes
+    // seq > since hasta last incluido, y llama a done(ok) en el io_context del socket
+    static void send(boost::asio::ip::tcp::socket& socket, FileManager& files,
+                     uint64_t since, uint64_t last, Done done);
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include "MultipartStreamParser.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <strings.h>
+
+MultipartStreamParser::MultipartStreamParser(const std::string& content_type, const std::string& staging_dir,
+                                             const std::string& file_field)
+    : staging_dir(staging_dir), file_field(file_field) {
+    std::string boundary = extractParam(content_type, "boundary");
+    if (boundary.empty() || content_type.find("multipart/") == std::string::npos) {
+        fail("Content-Type sin boundary multipart");
+        return;
+    }
+
+    delimiter = "\r\n--" + boundary;
+    // El primer boundary puede ir al inicio del body sin CRLF previo:
+    // anteponemos uno para que la búsqueda sea uniforme.
+    window = "\r\n";
+}
+
+MultipartStreamParser::~MultipartStreamParser() {
+    closeStagingFile();
+    if (!staging_path.empty()) {
+        unlink(staging_path.c_str());
+    }
+}
+
+void MultipartStreamParser::fail(const std::string& reason) {
+    if (error.empty()) {
+        error = reason;
+        std::cerr << "❌ Upload multipart: " << reason << std::endl;
+    }
+    closeStagingFile();
+}
+
+void MultipartStreamParser::feed(const char* data, size_t length) {
+    if (hasError() || state == State::Epilogue) {
+        return;
+    }
+
+    window.append(data, length);
+    size_t pos = 0;
+    bool need_more = false;
+
+    while (!need_more && !hasError() && state != State::Epilogue) {
+        switch (state) {
+            case State::Preamble: {
+                size_t found = window.find(delimiter, pos);
+                if (found == std::string::npos) {
+                    if (window.size() - pos >= delimiter.size()) {
+                        pos = window.size() - (delimiter.size() - 1);
+                    }
+                    need_more = true;
+                } else {
+                    pos = found + delimiter.size();
+                    state = State::AfterBoundary;
+                }
+                break;
+            }
+            case State::AfterBoundary: {
+                if (window.size() - pos < 2) {
+                    need_more = true;
+                } else if (window.compare(pos, 2, "--") == 0) {
+                    state = State::Epilogue;
+                } else if (window.compare(pos, 2, "\r\n") == 0) {
+                    pos += 2;
+                    state = State::Headers;
+                } else {
+                    fail("boundary malformado");
+                }
+                break;
+            }
+            case State::Headers: {
+                size_t found;
+                size_t skip;
+                if (window.size() - pos >= 2 && window.compare(pos, 2, "\r\n") == 0) {
+                    found = pos;  // parte sin cabeceras
+                    skip = 2;
+                } else {
+                    found = window.find("\r\n\r\n", pos);
+                    skip = 4;
+                }
+
+                if (found == std::string::npos) {
+                    if (window.size() - pos > MAX_HEADER_BYTES) {
+                        fail("cabeceras de parte demasiado grandes");
+                    }
+                    need_more = true;
+                } else {
+                    if (parsePartHeaders(window.substr(pos, found - pos))) {
+                        pos = found + skip;
+                        state = State::Body;
+                    }
+                }
+                break;
+            }
+            case State::Body: {
+                size_t found = window.find(delimiter, pos);
+                if (found == std::string::npos) {
+                    // Conservar lo justo para detectar un boundary partido entre dos lecturas
+                    size_t keep = delimiter.size() - 1;
+                    size_t available = window.size() - pos;
+                    if (available > keep) {
+                        emit(window.data() + pos, available - keep);
+                        pos += available - keep;
+                    }
+                    need_more = true;
+                } else {
+                    emit(window.data() + pos, found - pos);
+                    endPart();
+                    pos = found + delimiter.size();
+                    state = State::AfterBoundary;
+                }
+                break;
+            }
+            case State::Epilogue:
+                break;
+        }
+    }
+
+    if (state == State::Epilogue) {
+        window.clear();
+    } else {
+        window.erase(0, pos);
+    }
+}
+
+bool MultipartStreamParser::finish() {
+    if (!hasError() && state != State::Epilogue) {
+        fail("mensaje multipart incompleto");
+    }
+    return !hasError() && file_done;
+}
+
+bool MultipartStreamParser::parsePartHeaders(const std::string& raw_headers) {
+    part_name.clear();
+    part_is_file = false;
+
+    size_t start = 0;
+    while (start < raw_headers.size()) {
+        size_t end = raw_headers.find("\r\n", start);
+        if (end == std::string::npos) end = raw_headers.size();
+        std::string line = raw_headers.substr(start, end - start);
+        start = end + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = line.substr(0, colon);
+        if (strcasecmp(key.c_str(), "Content-Disposition") != 0) continue;
+
+        std::string value = line.substr(colon + 1);
+        part_name = extractParam(value, "name");
+
+        if (value.find("filename") != std::string::npos) {
+            std::string original = extractParam(value, "filename");
+            // Solo el nombre base: algunos navegadores antiguos envían la ruta completa
+            size_t slash = original.find_last_of("/\\");
+            if (slash != std::string::npos) original = original.substr(slash + 1);
+
+            if (part_name == file_field && !file_found && !original.empty() &&
+                original != "." && original != "..") {
+                filename = original;
+                file_found = true;
+                part_is_file = true;
+                if (!openStagingFile()) return false;
+            } else {
+                part_name.clear();  // archivo adicional: se ignora
+            }
+        }
+    }
+    return true;
+}
+
+bool MultipartStreamParser::openStagingFile() {
+    std::string tmpl = staging_dir + "/.upload_XXXXXX";
+    std::vector<char> path(tmpl.begin(), tmpl.end());
+    path.push_back('\0');
+
+    fd = mkstemp(path.data());
+    if (fd < 0) {
+        fail(std::string("no se pudo crear el archivo temporal: ") + strerror(errno));
+        return false;
+    }
+
+    staging_path = path.data();
+    write_buffer.resize(WRITE_BUFFER_BYTES);
+    write_used = 0;
+    return true;
+}
+
+void MultipartStreamParser::emit(const char* data, size_t length) {
+    if (length == 0) return;
+
+    if (part_is_file) {
+        file_size += length;
+        while (length > 0) {
+            size_t n = std::min(length, write_buffer.size() - write_used);
+            memcpy(write_buffer.data() + write_used, data, n);
+            write_used += n;
+            data += n;
+            length -= n;
+            if (write_used == write_buffer.size() && !flushWriteBuffer()) return;
+        }
+    }
+    // El resto de partes (campos de texto, archivos adicionales) se descarta
+}
+
+void MultipartStreamParser::endPart() {
+    if (part_is_file) {
+        if (flushWriteBuffer()) {
+            closeStagingFile();
+            digest = hasher.finish();
+            file_done = true;
+        }
+        part_is_file = false;
+    }
+    part_name.clear();
+}
+
+bool MultipartStreamParser::flushWriteBuffer() {
+    hasher.update(write_buffer.data(), write_used);
+
+    size_t offset = 0;
+    while (offset < write_used) {
+        ssize_t n = ::write(fd, write_buffer.data() + offset, write_used - offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail(std::string("error escribiendo archivo temporal: ") + strerror(errno));
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    write_used = 0;
+    return true;
+}
+
+void MultipartStreamParser::closeStagingFile() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    std::vector<char>().swap(write_buffer);
+}
+
+std::string MultipartStreamParser::extractParam(const std::string& header, const std::string& key) {
+    // Recorre "a=b; c=\"d\"" respetando comillas
+    size_t i = 0;
+    while (i < header.size()) {
+        while (i < header.size() && (header[i] == ' ' || header[i] == ';' || header[i] == '\t')) i++;
+
+        size_t eq = i;
+        while (eq < header.size() && header[eq] != '=' && header[eq] != ';') eq++;
+        std::string name = header.substr(i, eq - i);
+        while (!name.empty() && name.back() == ' ') name.pop_back();
+
+        if (eq >= header.size() || header[eq] == ';') {
+            i = eq;
+            continue;
+        }
+
+        size_t v = eq + 1;
+        while (v < header.size() && header[v] == ' ') v++;
+
+        std::string value;
+        if (v < header.size() && header[v] == '"') {
+            v++;
+            while (v < header.size() && header[v] != '"') {
+                // Solo \" es un escape: los navegadores no escapan la barra invertida
+                // y los antiguos envían rutas de Windows ("C:\fotos\a.jpg") tal cual
+                if (header[v] == '\\' && v + 1 < header.size() && header[v + 1] == '"') v++;
+                value += header[v++];
+            }
+            v++;
+        } else {
+            size_t end = header.find(';', v);
+            if (end == std::string::npos) end = header.size();
+            value = header.substr(v, end - v);
+            while (!value.empty() && value.back() == ' ') value.pop_back();
+        }
+
+        if (strcasecmp(name.c_str(), key.c_str()) == 0) {
+            return value;
+        }
+        i = v;
+    }
+    return "";
+}
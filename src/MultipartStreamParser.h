@@ -0,0 +1,83 @@
+#ifndef MULTIPART_STREAM_PARSER_H
+#define MULTIPART_STREAM_PARSER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "Sha256.h"
+
+// Parser incremental de multipart/form-data.
+// Recibe el body en trozos tal como llega del socket, busca el boundary
+// sin acumular el mensaje completo y escribe la parte del archivo
+// directamente en un fichero de staging dentro de staging_dir.
+// La memoria usada es fija (buffer de escritura + ventana del boundary).
+// El SHA-256 del archivo se calcula sobre la marcha, al volcar cada buffer.
+class MultipartStreamParser {
+public:
+    MultipartStreamParser(const std::string& content_type, const std::string& staging_dir,
+                          const std::string& file_field = "file");
+    ~MultipartStreamParser();
+
+    MultipartStreamParser(const MultipartStreamParser&) = delete;
+    MultipartStreamParser& operator=(const MultipartStreamParser&) = delete;
+
+    void feed(const char* data, size_t length);
+
+    // true si el mensaje terminó con el boundary final y el archivo se escribió completo
+    bool finish();
+
+    bool hasError() const { return !error.empty(); }
+    const std::string& getError() const { return error; }
+
+    bool hasFile() const { return file_found; }
+    const std::string& getFilename() const { return filename; }
+    const std::string& getStagingPath() const { return staging_path; }
+    size_t getFileSize() const { return file_size; }
+    // SHA-256 en hexadecimal; vacío hasta que el archivo está completo
+    const std::string& getDigest() const { return digest; }
+
+    // El llamador se queda con el fichero de staging (no se borra en el destructor)
+    void releaseStagingFile() { staging_path.clear(); }
+
+private:
+    enum class State { Preamble, Headers, Body, AfterBoundary, Epilogue };
+
+    static constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+    static constexpr size_t WRITE_BUFFER_BYTES = 256 * 1024;
+
+    State state = State::Preamble;
+    std::string delimiter;   // "\r\n--" + boundary
+    std::string window;      // bytes pendientes de clasificar (acotado)
+    std::string error;
+
+    std::string staging_dir;
+    std::string file_field;
+
+    // Parte actual
+    std::string part_name;
+    bool part_is_file = false;
+
+    // Archivo
+    bool file_found = false;
+    bool file_done = false;
+    std::string filename;
+    std::string staging_path;
+    int fd = -1;
+    size_t file_size = 0;
+    Sha256 hasher;
+    std::string digest;
+    std::vector<char> write_buffer;
+    size_t write_used = 0;
+
+    void fail(const std::string& reason);
+    bool parsePartHeaders(const std::string& raw_headers);
+    bool openStagingFile();
+    void emit(const char* data, size_t length);
+    void endPart();
+    bool flushWriteBuffer();
+    void closeStagingFile();
+
+    static std::string extractParam(const std::string& header, const std::string& key);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "RetentionManager.h"
+#include <iostream>
+
+RetentionManager::RetentionManager(FileManager& files, const Config& config, EvictionCallback on_eviction)
+    : files(files), cfg(config), on_eviction(std::move(on_eviction)) {}
+
+RetentionManager::~RetentionManager() {
+    stop();
+}
+
+void RetentionManager::start() {
+    if (!cfg.enabled() || worker.joinable()) return;
+    stopping = false;
+    worker = std::thread(&RetentionManager::run, this);
+}
+
+void RetentionManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+void RetentionManager::nudge() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending = true;
+    }
+    wake.notify_one();
+}
+
+RetentionManager::Stats RetentionManager::stats() const {
+    return {runs.load(), messages_trimmed.load(), files_removed.load(), bytes_freed.load()};
+}
+
+void RetentionManager::run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+        wake.wait_for(lock, cfg.interval, [this] { return pending || stopping; });
+        if (stopping) break;
+        pending = false;
+        
+        lock.unlock();
+        FileManager::Eviction eviction = files.enforceRetention(cfg.limits);
+        runs++;
+        messages_trimmed += eviction.messages_trimmed;
+        files_removed += eviction.files_removed;
+        bytes_freed += eviction.bytes_freed;
+        
+        if (eviction.messages_trimmed > 0 || eviction.files_removed > 0) {
+            std::cout << "🧽 Retención: " << eviction.messages_trimmed << " mensaje(s) y "
+                      << eviction.files_removed << " archivo(s) eliminados, "
+                      << eviction.bytes_freed << " bytes liberados" << std::endl;
+        }
+        if (!eviction.empty() && on_eviction) {
+            on_eviction(eviction);
+        }
+        lock.lock();
+    }
+}
+
+bool RetentionManager::parsePolicy(const std::string& name, bool& evict_least_downloaded) {
+    if (name == "oldest") evict_least_downloaded = false;
+    else if (name == "lru") evict_least_downloaded = true;
+    else return false;
+    return true;
+}
+
+const char* RetentionManager::policyName(bool evict_least_downloaded) {
+    return evict_least_downloaded ? "lru" : "oldest";
+}
@@ -0,0 +1,72 @@
+#ifndef RETENTION_MANAGER_H
+#define RETENTION_MANAGER_H
+
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include "FileManager.h"
+
+// Aplica los límites de retención de FileManager en un hilo propio: cada
+// `interval` y, sin esperar, cuando una publicación llama a nudge(). Las
+// peticiones nunca borran nada ellas mismas; como mucho despiertan al hilo.
+class RetentionManager {
+public:
+    struct Config {
+        FileManager::RetentionLimits limits;
+        std::chrono::seconds interval{60};
+        bool enabled() const {
+            return limits.max_age_ms > 0 || limits.max_bytes > 0 || limits.max_messages > 0;
+        }
+    };
+
+    struct Stats {
+        uint64_t runs;
+        uint64_t messages_trimmed;
+        uint64_t files_removed;
+        uint64_t bytes_freed;
+    };
+
+    // on_eviction se llama desde el hilo de retención cuando algo cambia
+    using EvictionCallback = std::function<void(const FileManager::Eviction&)>;
+
+    RetentionManager(FileManager& files, const Config& config, EvictionCallback on_eviction);
+    ~RetentionManager();
+
+    // Sin límites configurados no arranca ningún hilo
+    void start();
+    void stop();
+    // Pide una pasada cuanto antes (p. ej. tras publicar un archivo)
+    void nudge();
+
+    const Config& config() const { return cfg; }
+    Stats stats() const;
+
+    // "oldest" o "lru" (el archivo descargado hace más tiempo)
+    static bool parsePolicy(const std::string& name, bool& evict_least_downloaded);
+    static const char* policyName(bool evict_least_downloaded);
+
+private:
+    FileManager& files;
+    Config cfg;
+    EvictionCallback on_eviction;
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    bool pending = false;
+    bool stopping = false;
+    std::thread worker;
+
+    std::atomic<uint64_t> runs{0};
+    std::atomic<uint64_t> messages_trimmed{0};
+    std::atomic<uint64_t> files_removed{0};
+    std::atomic<uint64_t> bytes_freed{0};
+
+    void run();
+};
+
+#endif
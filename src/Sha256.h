@@ -0,0 +1,35 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// SHA-256 incremental (FIPS 180-4): se alimenta por trozos mientras llegan los
+// datos, sin tener el archivo completo en memoria.
+class Sha256 {
+public:
+    static constexpr size_t HEX_LENGTH = 64;
+
+    Sha256();
+
+    void update(const void* data, size_t length);
+    // Digest en hexadecimal (minúsculas); después el objeto queda listo para reutilizarse
+    std::string finish();
+
+    // "e3b0c442..." válido: 64 caracteres hexadecimales en minúsculas
+    static bool isHexDigest(const std::string& text);
+
+private:
+    uint32_t state[8];
+    uint64_t total = 0;
+    unsigned char block[64];
+    size_t used = 0;
+
+    void reset();
+    // Usa las instrucciones SHA de la CPU si las tiene
+    void transform(const unsigned char* data, size_t blocks);
+    void transformBlock(const unsigned char* chunk);
+};
+
+#endif
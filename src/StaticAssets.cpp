@@ -0,0 +1,99 @@
+#include "StaticAssets.h"
+#include <cstdlib>
+
+namespace StaticAssets {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+    return text;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+// Llama a f con cada elemento no vacío de una lista separada por comas
+template<typename F>
+void forEachItem(std::string_view list, F f) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = trim(list.substr(0, comma));
+        if (!item.empty()) f(item);
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 1);
+    }
+}
+
+} // namespace
+
+Encoding negotiate(std::string_view accept_encoding, bool has_gzip, bool has_brotli) {
+    // Sin cabecera: cualquier codificación vale, pero lo prudente es no comprimir
+    if (trim(accept_encoding).empty()) return Encoding::Identity;
+
+    // q por codificación; -1 = no mencionada
+    double q_gzip = -1, q_brotli = -1, q_identity = -1, q_any = -1;
+    forEachItem(accept_encoding, [&](std::string_view item) {
+        size_t semicolon = item.find(';');
+        std::string_view name = trim(item.substr(0, semicolon));
+        double q = 1;
+        if (semicolon != std::string_view::npos) {
+            std::string_view params = trim(item.substr(semicolon + 1));
+            if (params.size() > 2 && (params[0] == 'q' || params[0] == 'Q') && params[1] == '=') {
+                q = std::strtod(std::string(params.substr(2)).c_str(), nullptr);
+            }
+        }
+        if (equalsIgnoreCase(name, "gzip") || equalsIgnoreCase(name, "x-gzip")) q_gzip = q;
+        else if (equalsIgnoreCase(name, "br")) q_brotli = q;
+        else if (equalsIgnoreCase(name, "identity")) q_identity = q;
+        else if (name == "*") q_any = q;
+    });
+
+    if (q_gzip < 0) q_gzip = q_any < 0 ? 0 : q_any;
+    if (q_brotli < 0) q_brotli = q_any < 0 ? 0 : q_any;
+    // identity es aceptable salvo que se excluya explícitamente
+    if (q_identity < 0) q_identity = q_any == 0 ? 0 : 0.001;
+
+    Encoding best = Encoding::Identity;
+    double best_q = q_identity;
+    if (has_gzip && q_gzip > 0 && q_gzip >= best_q) {
+        best = Encoding::Gzip;
+        best_q = q_gzip;
+    }
+    if (has_brotli && q_brotli > 0 && q_brotli >= best_q) {
+        best = Encoding::Brotli;
+    }
+    return best;
+}
+
+const char* contentEncoding(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Brotli: return "br";
+        default: return nullptr;
+    }
+}
+
+bool etagMatches(std::string_view if_none_match, std::string_view etag) {
+    bool match = false;
+    forEachItem(if_none_match, [&](std::string_view tag) {
+        if (tag == "*") {
+            match = true;
+            return;
+        }
+        if (tag.size() > 2 && tag[0] == 'W' && tag[1] == '/') tag.remove_prefix(2);
+        if (tag == etag) match = true;
+    });
+    return match;
+}
+
+} // namespace StaticAssets
@@ -0,0 +1,32 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <string>
+#include <string_view>
+
+// Negociación HTTP de los recursos embebidos (resources.h, generado por
+// embed_resources.cmake): variante precomprimida y validación por ETag
+namespace StaticAssets {
+    enum class Encoding {
+        Identity,
+        Gzip,
+        Brotli
+    };
+
+    // Rutas con huella: el contenido de una URL no cambia nunca
+    constexpr const char* IMMUTABLE = "public, max-age=31536000, immutable";
+    // Rutas normales: el navegador guarda el recurso pero revalida con If-None-Match
+    constexpr const char* REVALIDATE = "no-cache";
+
+    // Mejor codificación disponible según Accept-Encoding (RFC 9110 §12.5.3):
+    // la de mayor q; a igualdad brotli, gzip, identity
+    Encoding negotiate(std::string_view accept_encoding, bool has_gzip, bool has_brotli);
+
+    // Valor de Content-Encoding; nullptr para Identity
+    const char* contentEncoding(Encoding encoding);
+
+    // If-None-Match (comparación débil, RFC 9110 §13.1.2): "*" o alguna etiqueta igual a etag
+    bool etagMatches(std::string_view if_none_match, std::string_view etag);
+}
+
+#endif
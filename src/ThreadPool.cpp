@@ -0,0 +1,126 @@
+#include "ThreadPool.h"
+#include <iostream>
+#include <cstdlib>
+#include <cerrno>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ThreadPool::ThreadPool(size_t threads, std::vector<int> cpus)
+    : thread_count(threads > 0 ? threads : 1), cpus(std::move(cpus)) {}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start() {
+    if (!workers.empty()) return;
+    stopping = false;
+    for (size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+size_t ThreadPool::queued() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return tasks.size();
+}
+
+void ThreadPool::run(size_t index) {
+    if (!cpus.empty()) {
+        int cpu = cpus[index % cpus.size()];
+        if (!CpuAffinity::pinCurrentThread(cpu)) {
+            std::cerr << "⚠️  No se pudo fijar el hilo de disco " << index << " a la CPU " << cpu << std::endl;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) break;  // stopping y sin nada pendiente
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "❌ Tarea de disco: " << e.what() << std::endl;
+        }
+        tasks_completed++;
+        lock.lock();
+    }
+}
+
+namespace CpuAffinity {
+
+namespace {
+
+bool parseCpu(const std::string& text, int& cpu) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    errno = 0;
+    long value = std::strtol(text.c_str(), nullptr, 10);
+    if (errno != 0 || value > 4095) return false;
+    cpu = static_cast<int>(value);
+    return true;
+}
+
+} // namespace
+
+bool parseList(const std::string& text, std::vector<int>& cpus) {
+    std::vector<int> result;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        std::string item = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t dash = item.find('-');
+        int first, last;
+        if (dash == std::string::npos) {
+            if (!parseCpu(item, first)) return false;
+            last = first;
+        } else if (!parseCpu(item.substr(0, dash), first) || !parseCpu(item.substr(dash + 1), last) || last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) result.push_back(cpu);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    cpus = std::move(result);
+    return !cpus.empty();
+}
+
+bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace CpuAffinity
@@ -0,0 +1,68 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Hilos para trabajo bloqueante (disco) que no debe correr en los hilos de red.
+// Las tareas se ejecutan en orden de llegada; con cpus no vacía el hilo i se
+// fija a cpus[i % cpus.size()].
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    ThreadPool(size_t threads, std::vector<int> cpus = {});
+    ~ThreadPool();
+
+    void start();
+    // Termina las tareas ya encoladas y espera a los hilos
+    void stop();
+    void post(Task task);
+
+    // Ejecuta work() en el pool y entrega su resultado con done(result) en io
+    // (el io_service de la conexión): el hilo de red nunca espera al disco.
+    // work no debe lanzar; el resultado puede no ser copiable.
+    template<typename Executor, typename Work, typename Done>
+    void submit(Executor& io, Work work, Done done) {
+        post([&io, work, done]() mutable {
+            auto result = std::make_shared<decltype(work())>(work());
+            io.post([result, done]() mutable { done(std::move(*result)); });
+        });
+    }
+
+    size_t size() const { return thread_count; }
+    size_t queued() const;
+    uint64_t completed() const { return tasks_completed.load(); }
+
+private:
+    size_t thread_count;
+    std::vector<int> cpus;
+
+    mutable std::mutex mtx;
+    std::condition_variable wake;
+    std::deque<Task> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    std::atomic<uint64_t> tasks_completed{0};
+
+    void run(size_t index);
+};
+
+namespace CpuAffinity {
+    // "0-3,6" -> {0,1,2,3,6}; false si la lista no es válida
+    bool parseList(const std::string& text, std::vector<int>& cpus);
+
+    // Fija el hilo actual a una CPU; false si el sistema lo rechaza o no lo soporta
+    bool pinCurrentThread(int cpu);
+}
+
+#endif
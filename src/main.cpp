@@ -1,22 +1,48 @@
 #include "../include/crow_all.h"
 #include <resources.h>
 #include "FileManager.h"
+#include "MultipartStreamParser.h"
+#include "DownloadEngine.h"
+#include "MessageStream.h"
+#include "HttpRange.h"
+#include "ChunkedUploadManager.h"
+#include "JsonUtil.h"
+#include "BroadcastHub.h"
+#include "BinaryProtocol.h"
+#include "Sha256.h"
+#include "RetentionManager.h"
+#include "StaticAssets.h"
+#include "ThreadPool.h"
 #include <iostream>
 #include <signal.h>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <fstream>
 #include <curl/curl.h>
 #include <thread>
 #include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
 
 std::unique_ptr<FileManager> g_file_manager;
-std::set<crow::websocket::connection*> g_ws_connections;
-std::mutex g_ws_mutex;
+std::unique_ptr<ChunkedUploadManager> g_upload_manager;
+std::unique_ptr<RetentionManager> g_retention;
+std::unique_ptr<ThreadPool> g_disk_pool;
+BroadcastHub g_ws_hub;
 
 void signalHandler(int signum) {
     std::cout << "\n🛑 Señal de interrupción recibida (" << signum << ")" << std::endl;
     
+    if (g_retention) {
+        g_retention->stop();
+    }
+    if (g_upload_manager) {
+        g_upload_manager->stop();
+    }
+    if (g_disk_pool) {
+        g_disk_pool->stop();
+    }
     if (g_file_manager) {
         g_file_manager->cleanup();
     }
@@ -24,11 +50,250 @@ void signalHandler(int signum) {
     exit(signum);
 }
 
-void broadcastToAllClients(const std::string& message) {
-    std::lock_guard<std::mutex> lock(g_ws_mutex);
-    for (auto* conn : g_ws_connections) {
-        conn->send_text(message);
+// Base de los sinks que escriben a disco: feed() (hilo de red) solo copia a
+// la cola y el pool la escribe en orden, con una sola tarea a la vez y en
+// bloques de FLUSH_BYTES o más (salvo el último). Con MAX_PENDING_BYTES entre
+// la cola y el bloque que se está escribiendo la conexión deja de leer, así
+// que cada subida retiene como mucho dos buffers de ese tamaño (más el del
+// parser). El handler no corre hasta que todo está escrito.
+class PooledBodySink : public crow::body_sink, public std::enable_shared_from_this<PooledBodySink> {
+public:
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+    static constexpr size_t MAX_PENDING_BYTES = 128 * 1024;
+    
+    void feed(const char* data, size_t length) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        queued.append(data, length);
+        if (queued.size() >= FLUSH_BYTES) scheduleLocked();
+    }
+    
+    bool ready(bool complete, std::function<void()> resume) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (complete && !queued.empty()) scheduleLocked();
+        if (canContinueLocked(complete)) return true;
+        waiter = std::move(resume);
+        waiter_complete = complete;
+        return false;
+    }
+    
+protected:
+    // En un hilo del pool, en el orden en que llegaron los datos
+    virtual void consume(const char* data, size_t length) = 0;
+    
+private:
+    std::mutex mtx;
+    std::string queued;
+    size_t in_flight = 0;  // bytes del bloque que el pool está escribiendo
+    bool draining = false;
+    std::function<void()> waiter;
+    bool waiter_complete = false;
+    
+    bool canContinueLocked(bool complete) const {
+        return complete ? !draining && queued.empty() : queued.size() + in_flight < MAX_PENDING_BYTES;
+    }
+    
+    void scheduleLocked() {
+        if (draining) return;
+        draining = true;
+        auto self = shared_from_this();
+        g_disk_pool->post([self] { self->drain(); });
+    }
+    
+    // Se intercambian dos buffers: mientras uno va a disco el otro se llena
+    void drain() {
+        std::string batch;
+        for (;;) {
+            std::function<void()> resume;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                batch.clear();
+                batch.swap(queued);
+                in_flight = batch.size();
+                if (batch.empty()) draining = false;
+                if (waiter && canContinueLocked(waiter_complete)) resume.swap(waiter);
+            }
+            if (resume) resume();
+            if (batch.empty()) return;
+            consume(batch.data(), batch.size());
+        }
     }
+};
+
+// Recibe el body de /api/upload directamente desde el socket:
+// el archivo va a disco a medida que llega, nunca completo en RAM
+struct UploadBodySink : public PooledBodySink {
+    MultipartStreamParser parser;
+    
+    UploadBodySink(const std::string& content_type, const std::string& staging_dir)
+        : parser(content_type, staging_dir) {}
+    
+    void consume(const char* data, size_t length) override {
+        parser.feed(data, length);
+    }
+};
+
+// Recibe un trozo de /api/uploads/<id> y lo escribe con pwrite en su offset.
+// Sin sesión válida descarta los datos (el handler responde el error).
+struct ChunkBodySink : public PooledBodySink {
+    std::shared_ptr<UploadSession> session;
+    size_t offset = 0;
+    size_t written = 0;
+    UploadSession::WriteResult result = UploadSession::WriteResult::Ok;
+    
+    void feed(const char* data, size_t length) override {
+        if (session) PooledBodySink::feed(data, length);
+    }
+    
+    void consume(const char* data, size_t length) override {
+        if (result != UploadSession::WriteResult::Ok) return;
+        if (written + length > ChunkedUploadManager::MAX_CHUNK_SIZE) {
+            result = UploadSession::WriteResult::OutOfRange;
+            return;
+        }
+        result = session->write(offset + written, data, length);
+        if (result == UploadSession::WriteResult::Ok) written += length;
+    }
+};
+
+// "123" -> 123; false si no es un número decimal completo
+bool parseOffset(const char* text, size_t& value) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || text[0] == '-') return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// Variable de entorno numérica; fallback si no existe o no es un número
+size_t envSize(const char* name, size_t fallback) {
+    size_t value;
+    return parseOffset(getenv(name), value) ? value : fallback;
+}
+
+// Presupuesto de envío por cliente WebSocket (ver BroadcastHub::Config):
+//   AUTOSYNC_WS_MAX_QUEUE_BYTES, AUTOSYNC_WS_MAX_QUEUE_MESSAGES,
+//   AUTOSYNC_WS_OVERFLOW=disconnect|drop-oldest|resync
+BroadcastHub::Config loadBroadcastConfig() {
+    BroadcastHub::Config config;
+    config.max_queued_bytes = envSize("AUTOSYNC_WS_MAX_QUEUE_BYTES", config.max_queued_bytes);
+    config.max_queued_messages = envSize("AUTOSYNC_WS_MAX_QUEUE_MESSAGES", config.max_queued_messages);
+    
+    const char* policy = getenv("AUTOSYNC_WS_OVERFLOW");
+    if (policy && !BroadcastHub::parsePolicy(policy, config.policy)) {
+        std::cerr << "⚠️  AUTOSYNC_WS_OVERFLOW desconocida: " << policy << " (se usa "
+                  << BroadcastHub::policyName(config.policy) << ")" << std::endl;
+    }
+    
+    // El cliente pide a /api/messages?since= lo que se haya descartado
+    config.resync_message = "{\"type\":\"resync_needed\"}";
+    config.resync_binary = BinaryProtocol::resyncNeeded();
+    return config;
+}
+
+// permessage-deflate en /ws:
+//   AUTOSYNC_WS_DEFLATE=0 lo desactiva, AUTOSYNC_WS_DEFLATE_THRESHOLD (bytes),
+//   AUTOSYNC_WS_DEFLATE_CONTEXT_TAKEOVER=1 comprime mejor los mensajes pequeños
+//   a cambio de un compresor (~256 KB) por cliente y de comprimir por cliente
+crow::websocket::deflate_options loadDeflateOptions() {
+    crow::websocket::deflate_options options;
+    options.enabled = envSize("AUTOSYNC_WS_DEFLATE", 1) != 0;
+    options.threshold = envSize("AUTOSYNC_WS_DEFLATE_THRESHOLD", options.threshold);
+    options.server_no_context_takeover = envSize("AUTOSYNC_WS_DEFLATE_CONTEXT_TAKEOVER", 0) == 0;
+    return options;
+}
+
+// Retención de temp_shared (0 = sin límite; sin ninguno no se borra nada):
+//   AUTOSYNC_RETENTION_MAX_AGE (segundos), AUTOSYNC_RETENTION_MAX_BYTES,
+//   AUTOSYNC_RETENTION_MAX_MESSAGES, AUTOSYNC_RETENTION_POLICY=oldest|lru,
+//   AUTOSYNC_RETENTION_INTERVAL (segundos entre pasadas)
+RetentionManager::Config loadRetentionConfig() {
+    RetentionManager::Config config;
+    config.limits.max_age_ms = static_cast<int64_t>(envSize("AUTOSYNC_RETENTION_MAX_AGE", 0)) * 1000;
+    config.limits.max_bytes = envSize("AUTOSYNC_RETENTION_MAX_BYTES", 0);
+    config.limits.max_messages = envSize("AUTOSYNC_RETENTION_MAX_MESSAGES", 0);
+    config.interval = std::chrono::seconds(std::max<size_t>(1, envSize("AUTOSYNC_RETENTION_INTERVAL", 60)));
+    
+    const char* policy = getenv("AUTOSYNC_RETENTION_POLICY");
+    if (policy && !RetentionManager::parsePolicy(policy, config.limits.evict_least_downloaded)) {
+        std::cerr << "⚠️  AUTOSYNC_RETENTION_POLICY desconocida: " << policy << " (se usa "
+                  << RetentionManager::policyName(config.limits.evict_least_downloaded) << ")" << std::endl;
+    }
+    return config;
+}
+
+// Cada variable AUTOSYNC_* se puede dar también como argumento, con prioridad:
+// --ws-overflow=resync equivale a AUTOSYNC_WS_OVERFLOW=resync y --persist a AUTOSYNC_PERSIST=1
+bool applyArguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0 || arg.size() == 2) {
+            std::cerr << "❌ Argumento no válido: " << arg << " (se espera --nombre=valor)" << std::endl;
+            return false;
+        }
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "1" : arg.substr(equals + 1);
+        
+        std::string variable = "AUTOSYNC_";
+        for (char c : name) {
+            variable += c == '-' ? '_' : static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        }
+        setenv(variable.c_str(), value.c_str(), 1);
+    }
+    return true;
+}
+
+// Red y hilos:
+//   AUTOSYNC_PORT (8081), AUTOSYNC_BIND (0.0.0.0),
+//   AUTOSYNC_THREADS (hilos de red; 0 = uno por hilo hardware, mínimo 2),
+//   AUTOSYNC_CPUS (lista "0-3,6": fija los hilos de red, uno por CPU en orden),
+//   AUTOSYNC_DISK_THREADS (hilos para el trabajo de disco, 4), AUTOSYNC_DISK_CPUS
+struct ServerConfig {
+    uint16_t port = 8081;
+    std::string bind = "0.0.0.0";
+    uint16_t threads = 0;
+    std::vector<int> cpus;
+    size_t disk_threads = 4;
+    std::vector<int> disk_cpus;
+};
+
+bool loadCpuList(const char* name, std::vector<int>& cpus) {
+    const char* text = getenv(name);
+    if (!text || !*text) return true;
+    if (!CpuAffinity::parseList(text, cpus)) {
+        std::cerr << "❌ " << name << " no es una lista de CPUs válida: " << text << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadServerConfig(ServerConfig& config) {
+    size_t port = envSize("AUTOSYNC_PORT", config.port);
+    if (port > 65535) {
+        std::cerr << "❌ AUTOSYNC_PORT fuera de rango: " << port << std::endl;
+        return false;
+    }
+    config.port = static_cast<uint16_t>(port);
+    
+    const char* bind = getenv("AUTOSYNC_BIND");
+    if (bind && *bind) {
+        boost::system::error_code ec;
+        boost::asio::ip::make_address(bind, ec);
+        if (ec) {
+            std::cerr << "❌ AUTOSYNC_BIND no es una dirección IP: " << bind << std::endl;
+            return false;
+        }
+        config.bind = bind;
+    }
+    
+    size_t threads = envSize("AUTOSYNC_THREADS", 0);
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    config.threads = static_cast<uint16_t>(std::min<size_t>(std::max<size_t>(threads, 2), 1024));
+    config.disk_threads = std::min<size_t>(std::max<size_t>(envSize("AUTOSYNC_DISK_THREADS", config.disk_threads), 1), 256);
+    
+    return loadCpuList("AUTOSYNC_CPUS", config.cpus) && loadCpuList("AUTOSYNC_DISK_CPUS", config.disk_cpus);
 }
 
 std::string getClientIP(const crow::request& req) {
@@ -43,51 +308,351 @@ std::string getClientIP(const crow::request& req) {
 }
 
 
-int main() {
+crow::response jsonResponse(std::string body, int code = 200) {
+    crow::response res(code, std::move(body));
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// Handlers que tocan el disco (journal con fdatasync, enlaces, open, unlink):
+// work construye la respuesta en el pool de disco y res.end() se llama en el
+// hilo de red de la conexión, que mientras tanto atiende a otros clientes
+template<typename Work>
+void respondFromDisk(const crow::request& req, crow::response& res, Work work) {
+    g_disk_pool->submit(*req.io_service,
+        [work]() mutable {
+            try {
+                return work();
+            } catch (const std::exception& e) {
+                std::cerr << "❌ Error en el pool de disco: " << e.what() << std::endl;
+                return crow::response(500, "Internal error");
+            }
+        },
+        [&res](crow::response response) {
+            res = std::move(response);
+            res.end();
+        });
+}
+
+// Se serializa una vez por formato, no una vez por cliente
+void announceMessage(const Message& msg) {
+    std::string notification;
+    notification.reserve(msg.stringsSize() + 200);
+    notification += "{\"type\":\"new_message\",\"message\":";
+    JsonUtil::appendMessage(notification, msg);
+    notification += '}';
+    g_ws_hub.broadcast(notification, BinaryProtocol::newMessage(msg));
+}
+
+// {"type":"evicted","first_seq":N,"files":[ids]}: el cliente quita los mensajes
+// anteriores a first_seq y marca esos archivos como no disponibles
+void sendEvicted(crow::websocket::connection* conn, uint64_t first_seq, const std::vector<uint64_t>& file_ids) {
+    JsonUtil::Writer writer(64 + file_ids.size() * 17);
+    writer.beginObject()
+        .key("type").value("evicted")
+        .key("first_seq").value(first_seq)
+        .key("files").beginArray();
+    for (uint64_t id : file_ids) {
+        writer.value(id);
+    }
+    std::string json = writer.endArray().endObject().take();
+    
+    std::string binary = BinaryProtocol::evicted(first_seq, file_ids);
+    if (!conn) {
+        g_ws_hub.broadcast(json, binary);
+    } else if (conn->subprotocol() == BinaryProtocol::SUBPROTOCOL) {
+        conn->send_binary(binary);
+    } else {
+        conn->send_text(json);
+    }
+}
+
+// Notifica por WebSocket un archivo recién publicado y construye la respuesta del upload
+crow::response announceFileMessage(const MessagePtr& msg) {
+    announceMessage(*msg);
+    if (g_retention) {
+        g_retention->nudge();  // la cuota de disco se comprueba ya, no en la próxima pasada
+    }
+    
+    JsonUtil::Writer json;
+    json.beginObject()
+        .key("success").value(true)
+        .key("message_id").value(msg->id)
+        .key("filename").value(msg->filename())
+        .endObject();
+    return jsonResponse(json.take());
+}
+
+// Recurso embebido en la mejor variante que acepta el cliente. Las rutas con
+// huella nunca cambian de contenido; las demás se revalidan con la ETag.
+crow::response resourceResponse(const crow::request& req, const Resources::Resource& resource, bool fingerprinted) {
+    auto encoding = StaticAssets::negotiate(req.get_header_value("Accept-Encoding"),
+                                            resource.gzip.size > 0, resource.brotli.size > 0);
+    const Resources::Encoded* variant = nullptr;
+    if (encoding == StaticAssets::Encoding::Gzip) variant = &resource.gzip;
+    if (encoding == StaticAssets::Encoding::Brotli) variant = &resource.brotli;
+    std::string_view etag = variant ? variant->etag : resource.etag;
+    
+    crow::response response;
+    response.set_header("ETag", std::string(etag));
+    response.set_header("Cache-Control", fingerprinted ? StaticAssets::IMMUTABLE : StaticAssets::REVALIDATE);
+    if (resource.gzip.size > 0 || resource.brotli.size > 0) {
+        response.set_header("Vary", "Accept-Encoding");
+    }
+    
+    if (StaticAssets::etagMatches(req.get_header_value("If-None-Match"), etag)) {
+        response.code = 304;
+        response.manual_length_header = true;  // un 304 no lleva Content-Length: 0
+        return response;
+    }
+    
+    std::string_view body = variant ? variant->bytes() : resource.content;
+    response.set_header("Content-Type", std::string(resource.mime_type));
+    if (variant) {
+        response.set_header("Content-Encoding", StaticAssets::contentEncoding(encoding));
+    }
+    // Los datos están en el binario: se envían sin copiarlos
+    response.set_static_body(body.data(), body.size());
+    return response;
+}
+
+// Descarga ya abierta (open + fstat en el pool de disco); corre en el hilo de
+// red de la conexión. El cuerpo lo envía DownloadEngine (splice por un pipe), con Range.
+void startDownload(const crow::request& req, crow::response& res, const std::string& filename,
+                   std::shared_ptr<OpenFile> file) {
+    if (!file) {
+        res.code = 404;
+        res.body = "File not found";
+        res.end();
+        return;
+    }
+    
+    size_t file_size = file->size();
+    std::string etag = HttpRange::makeETag(file->st);
+    std::string last_modified = HttpRange::lastModified(file->st);
+    
+    // Range solo se respeta si If-Range (cuando viene) coincide con la versión actual
+    std::vector<ByteRange> ranges;
+    RangeRequest range_request = RangeRequest::None;
+    const std::string& range_header = req.get_header_value("Range");
+    if (!range_header.empty() &&
+        HttpRange::ifRangeMatches(req.get_header_value("If-Range"), etag, last_modified)) {
+        range_request = HttpRange::parse(range_header, file_size, ranges);
+    }
+    
+    res.set_header("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+    res.set_header("Accept-Ranges", "bytes");
+    res.set_header("ETag", etag);
+    res.set_header("Last-Modified", last_modified);
+    res.set_header("Cache-Control", "no-cache");
+    
+    if (range_request == RangeRequest::Unsatisfiable) {
+        res.code = 416;
+        res.set_header("Content-Range", "bytes */" + std::to_string(file_size));
+        res.end();
+        return;
+    }
+    
+    std::vector<DownloadEngine::Segment> segments;
+    std::string trailer;
+    size_t content_length = 0;
+    
+    if (range_request == RangeRequest::None) {
+        res.code = 200;
+        res.set_header("Content-Type", "application/octet-stream");
+        segments.push_back({"", 0, file_size});
+        content_length = file_size;
+    } else if (ranges.size() == 1) {
+        res.code = 206;
+        res.set_header("Content-Type", "application/octet-stream");
+        res.set_header("Content-Range", HttpRange::contentRange(ranges[0], file_size));
+        segments.push_back({"", static_cast<off_t>(ranges[0].first), ranges[0].length()});
+        content_length = ranges[0].length();
+    } else {
+        std::string boundary = HttpRange::makeBoundary();
+        res.code = 206;
+        res.set_header("Content-Type", "multipart/byteranges; boundary=" + boundary);
+        
+        for (const auto& range : ranges) {
+            std::string prefix = "\r\n--" + boundary + "\r\n"
+                                 "Content-Type: application/octet-stream\r\n"
+                                 "Content-Range: " + HttpRange::contentRange(range, file_size) + "\r\n\r\n";
+            content_length += prefix.size() + range.length();
+            segments.push_back({std::move(prefix), static_cast<off_t>(range.first), range.length()});
+        }
+        trailer = "\r\n--" + boundary + "--\r\n";
+        content_length += trailer.size();
+    }
+    
+    res.set_header("Content-Length", std::to_string(content_length));
+    
+    // 📊 Log inicio de descarga
+    std::cout << "⬇️  Iniciando descarga: " << filename 
+              << " (" << (content_length / 1024.0 / 1024.0) << " MB";
+    if (range_request == RangeRequest::Satisfiable) {
+        std::cout << ", " << ranges.size() << " rango(s)";
+    }
+    std::cout << ")" << std::endl;
+    
+    // El cuerpo pasa del archivo al socket por un pipe: el pool lee, el worker solo envía
+    res.set_async_body_writer([file, segments, trailer, filename](boost::asio::ip::tcp::socket& socket, std::function<void(bool)> done) {
+        DownloadEngine::send(socket, *g_disk_pool, file, segments, trailer, [done, filename](bool ok) {
+            if (ok) {
+                std::cout << "✅ Descarga completa: " << filename << std::endl;
+            } else {
+                std::cout << "⚠️  Descarga interrumpida: " << filename << std::endl;
+            }
+            done(ok);
+        });
+    });
+    
+    res.end();
+}
+
+// Nombre de archivo enviado por el cliente: sin rutas; vacío si no es válido
+std::string sanitizeFilename(std::string filename) {
+    size_t slash = filename.find_last_of("/\\");
+    if (slash != std::string::npos) filename = filename.substr(slash + 1);
+    if (filename == "." || filename == "..") return "";
+    return filename;
+}
+
+// Estado de una subida por trozos: qué intervalos ya están en disco
+std::string uploadStatus(UploadSession& session) {
+    auto ranges = session.receivedRanges();
+    
+    JsonUtil::Writer json(128 + ranges.size() * 48);
+    json.beginObject()
+        .key("upload_id").value(session.id)
+        .key("size").value(session.size)
+        .key("chunk_size").value(ChunkedUploadManager::CHUNK_SIZE)
+        .key("received").value(session.receivedBytes())
+        .key("ranges").beginArray();
+    for (const auto& range : ranges) {
+        json.beginArray().value(range.first).value(range.second).endArray();
+    }
+    json.endArray().endObject();
+    return json.take();
+}
+
+int main(int argc, char* argv[]) {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
     
+    ServerConfig server;
+    if (!applyArguments(argc, argv) || !loadServerConfig(server)) {
+        return 1;
+    }
+    g_disk_pool = std::make_unique<ThreadPool>(server.disk_threads, server.disk_cpus);
+    g_disk_pool->start();
+    
     g_file_manager = std::make_unique<FileManager>();
     
+    // AUTOSYNC_PERSIST=1: el historial y los archivos sobreviven a reinicios;
+    // AUTOSYNC_SNAPSHOT_BYTES: tamaño del journal a partir del cual se compacta
+    if (envSize("AUTOSYNC_PERSIST", 0) != 0 &&
+        !g_file_manager->enablePersistence(envSize("AUTOSYNC_SNAPSHOT_BYTES", 64 * 1024 * 1024))) {
+        std::cerr << "❌ No se pudo activar el modo persistente" << std::endl;
+        return 1;
+    }
+    g_upload_manager = std::make_unique<ChunkedUploadManager>(g_file_manager->getTempDir());
+    g_upload_manager->start();
+    
+    BroadcastHub::Config ws_config = loadBroadcastConfig();
+    g_ws_hub.configure(ws_config);
+    std::cout << "📡 Presupuesto por cliente WebSocket: " << ws_config.max_queued_bytes << " bytes / "
+              << ws_config.max_queued_messages << " mensajes, política "
+              << BroadcastHub::policyName(ws_config.policy) << std::endl;
+    
+    RetentionManager::Config retention = loadRetentionConfig();
+    g_retention = std::make_unique<RetentionManager>(*g_file_manager, retention,
+        [](const FileManager::Eviction& eviction) {
+            sendEvicted(nullptr, eviction.first_seq, eviction.files);
+        });
+    if (retention.enabled()) {
+        std::cout << "🧽 Retención: edad " << retention.limits.max_age_ms / 1000 << " s, "
+                  << retention.limits.max_bytes << " bytes, " << retention.limits.max_messages
+                  << " mensajes (0 = sin límite), política "
+                  << RetentionManager::policyName(retention.limits.evict_least_downloaded) << std::endl;
+        g_retention->start();
+    }
+    
+    crow::websocket::deflate_options ws_deflate = loadDeflateOptions();
+    if (ws_deflate.enabled) {
+        std::cout << "🗜️  permessage-deflate a partir de " << ws_deflate.threshold << " bytes"
+                  << (ws_deflate.server_no_context_takeover ? "" : ", con context takeover") << std::endl;
+    }
+    
     crow::SimpleApp app;
 
+    // Bodies que se procesan en streaming en lugar de acumularse en req.body
+    app.body_sink_factory([](crow::HTTPMethod method, const std::string& raw_url, const crow::ci_map& headers)
+                          -> std::shared_ptr<crow::body_sink> {
+        std::string path = raw_url.substr(0, raw_url.find('?'));
+        if (method == crow::HTTPMethod::POST && path == "/api/upload") {
+            return std::make_shared<UploadBodySink>(crow::get_header_value(headers, "Content-Type"),
+                                                    g_file_manager->getTempDir());
+        }
+        if (method == crow::HTTPMethod::PUT && path.compare(0, 13, "/api/uploads/") == 0) {
+            auto sink = std::make_shared<ChunkBodySink>();
+            crow::query_string params(raw_url);
+            if (parseOffset(params.get("offset"), sink->offset)) {
+                sink->session = g_upload_manager->get(path.substr(13));
+            }
+            return sink;
+        }
+        return nullptr;
+    });
+
     // ============================================
     // WebSocket
     // ============================================
+    // Subprotocolos: "autosync.v2.bin" (BinaryProtocol.h) o JSON, que es también
+    // lo que se usa si el cliente no pide ninguno
     CROW_ROUTE(app, "/ws")
     .websocket()
+    .subprotocols({BinaryProtocol::SUBPROTOCOL, "autosync.v2.json"})
+    .permessage_deflate(ws_deflate)
     .onopen([](crow::websocket::connection& conn){
-        std::lock_guard<std::mutex> lock(g_ws_mutex);
-        g_ws_connections.insert(&conn);
-        std::cout << "🔌 Cliente conectado via WebSocket" << std::endl;
+        bool binary = conn.subprotocol() == BinaryProtocol::SUBPROTOCOL;
         
-        auto messages = g_file_manager->getAllMessages();
-        crow::json::wvalue response;
-        response["type"] = "initial_state";
-        response["messages"] = crow::json::wvalue::list();
+        // Registrar antes de leer el historial: un mensaje publicado entre medias
+        // puede llegar dos veces (el cliente descarta seq repetidos), nunca perderse
+        g_ws_hub.add(conn, binary);
         
-        for (size_t i = 0; i < messages.size(); i++) {
-            auto& msg = messages[i];
-            crow::json::wvalue m;
-            m["id"] = msg.id;
-            m["type"] = msg.type;
-            m["content"] = msg.content;
-            m["timestamp"] = msg.timestamp;
-            m["sender_ip"] = msg.sender_ip;
-            
-            if (msg.type == "file") {
-                m["filename"] = msg.filename;
-                m["filesize"] = msg.filesize;
-            }
-            
-            response["messages"][i] = std::move(m);
+        // /ws?since=N: el cliente reconecta y solo pide lo que se perdió
+        uint64_t since = 0;
+        size_t parsed;
+        if (parseOffset(conn.url_params().get("since"), parsed)) {
+            since = parsed;
+        }
+        std::cout << "🔌 Cliente conectado via WebSocket" << (binary ? " [binario]" : "")
+                  << (conn.compressed() ? " [deflate]" : "")
+                  << (since > 0 ? " (reanudando desde " + std::to_string(since) + ")" : "") << std::endl;
+        
+        uint64_t first_seq = g_file_manager->firstSeq();
+        auto messages = g_file_manager->getMessagesSince(since);
+        if (binary) {
+            conn.send_binary(BinaryProtocol::initialState(since, messages));
+        } else {
+            JsonUtil::Writer json;
+            json.beginObject()
+                .key("type").value("initial_state")
+                .key("since").value(since)
+                .key("messages").messages(messages)
+                .endObject();
+            conn.send_text(json.take());
         }
         
-        conn.send_text(response.dump());
+        // Lo que la retención borró: mensajes que un cliente que reanuda aún
+        // muestra y archivos cuyo mensaje sigue en el historial
+        auto evicted_files = g_file_manager->evictedFiles();
+        if (!evicted_files.empty() || (since > 0 && since + 1 < first_seq)) {
+            sendEvicted(&conn, first_seq, evicted_files);
+        }
     })
     .onclose([](crow::websocket::connection& conn, const std::string&){
-        std::lock_guard<std::mutex> lock(g_ws_mutex);
-        g_ws_connections.erase(&conn);
+        g_ws_hub.remove(conn);
         std::cout << "🔌 Cliente desconectado" << std::endl;
     })
     .onmessage([](crow::websocket::connection&, const std::string& data, bool){
@@ -100,240 +665,399 @@ int main() {
     
     CROW_ROUTE(app, "/api/my_ip")
     ([](const crow::request& req){
-        crow::json::wvalue response;
-        response["ip"] = getClientIP(req);
-        return response;
+        JsonUtil::Writer json;
+        json.beginObject().key("ip").value(getClientIP(req)).endObject();
+        return jsonResponse(json.take());
     });
     
     CROW_ROUTE(app, "/api/status")
     ([](){
-        crow::json::wvalue status;
-        status["status"] = "running";
-        status["message"] = "AutoSync Server está activo";
-        status["resources_loaded"] = Resources::RESOURCE_MAP.size();
-        status["total_messages"] = g_file_manager->getAllMessages().size();
-        status["temp_dir"] = g_file_manager->getTempDir();
-        return status;
+        auto ws_stats = g_ws_hub.stats();
+        auto retention_stats = g_retention->stats();
+        auto blob_stats = g_file_manager->blobStats();
+        auto journal_stats = g_file_manager->journalStats();
+        
+        JsonUtil::Writer json(1024);
+        json.beginObject()
+            .key("status").value("running")
+            .key("message").value("AutoSync Server está activo")
+            .key("resources_loaded").value(Resources::RESOURCE_COUNT)
+            .key("total_messages").value(g_file_manager->count())
+            .key("websocket_clients").value(g_ws_hub.size())
+            .key("websocket").beginObject()
+                .key("clients_throttled").value(ws_stats.clients_throttled)
+                .key("messages_dropped").value(ws_stats.messages_dropped)
+                .key("resyncs_sent").value(ws_stats.resyncs_sent)
+                .key("clients_disconnected").value(ws_stats.clients_disconnected)
+            .endObject()
+            .key("retention").beginObject()
+                .key("enabled").value(g_retention->config().enabled())
+                .key("policy").value(RetentionManager::policyName(g_retention->config().limits.evict_least_downloaded))
+                .key("first_seq").value(g_file_manager->firstSeq())
+                .key("messages_trimmed").value(retention_stats.messages_trimmed)
+                .key("files_removed").value(retention_stats.files_removed)
+                .key("bytes_freed").value(retention_stats.bytes_freed)
+            .endObject()
+            .key("disk_pool").beginObject()
+                .key("threads").value(g_disk_pool->size())
+                .key("queued").value(g_disk_pool->queued())
+                .key("completed").value(g_disk_pool->completed())
+            .endObject()
+            .key("storage").beginObject()
+                .key("blobs").value(blob_stats.blobs)
+                .key("bytes_stored").value(blob_stats.bytes_stored)
+                .key("bytes_deduplicated").value(blob_stats.bytes_deduplicated)
+            .endObject()
+            .key("persistence").beginObject()
+                .key("enabled").value(g_file_manager->isPersistent())
+                .key("records").value(journal_stats.records)
+                .key("commits").value(journal_stats.commits)
+                .key("journal_bytes").value(journal_stats.journal_bytes)
+                .key("snapshots").value(journal_stats.snapshots)
+            .endObject()
+            .key("temp_dir").value(g_file_manager->getTempDir())
+            .endObject();
+        return jsonResponse(json.take());
     });
 
+    // /api/messages?since=<seq>&limit=<n>: página de mensajes posteriores a seq
     CROW_ROUTE(app, "/api/messages")
-    ([](){
-        auto messages = g_file_manager->getAllMessages();
-        crow::json::wvalue response;
-        response["messages"] = crow::json::wvalue::list();
+    ([](const crow::request& req, crow::response& res){
+        size_t since = 0;
+        size_t limit = 0;
+        if ((req.url_params.get("since") && !parseOffset(req.url_params.get("since"), since)) ||
+            (req.url_params.get("limit") && !parseOffset(req.url_params.get("limit"), limit))) {
+            res = crow::response(400, "Invalid 'since' or 'limit'");
+            res.end();
+            return;
+        }
         
-        for (size_t i = 0; i < messages.size(); i++) {
-            auto& msg = messages[i];
-            crow::json::wvalue m;
-            m["id"] = msg.id;
-            m["type"] = msg.type;
-            m["content"] = msg.content;
-            m["timestamp"] = msg.timestamp;
-            m["sender_ip"] = msg.sender_ip;
-            
-            if (msg.type == "file") {
-                m["filename"] = msg.filename;
-                m["filesize"] = msg.filesize;
-            }
-            
-            response["messages"][i] = std::move(m);
+        // Páginas grandes en streaming: memoria constante sea cual sea el historial
+        uint64_t start = std::max<uint64_t>(since, g_file_manager->firstSeq() - 1);
+        uint64_t last = g_file_manager->lastSeq();
+        uint64_t count = last > start ? last - start : 0;
+        if (limit > 0 && count > limit) count = limit;
+        if (count > MessageStream::MIN_MESSAGES && req.check_version(1, 1)) {
+            res.code = 200;
+            res.set_header("Content-Type", "application/json");
+            res.set_header("Transfer-Encoding", "chunked");
+            res.manual_length_header = true;
+            res.set_async_body_writer([start, end = start + count](boost::asio::ip::tcp::socket& socket, std::function<void(bool)> done) {
+                MessageStream::send(socket, *g_file_manager, start, end, std::move(done));
+            });
+            res.end();
+            return;
         }
         
-        return response;
+        auto messages = g_file_manager->getMessagesSince(since, limit);
+        uint64_t last_seq = messages.empty() ? since : messages.back()->seq;
+        
+        bool has_more = last_seq < g_file_manager->lastSeq();
+        
+        JsonUtil::Writer json;
+        json.beginObject()
+            .key("messages").messages(messages)
+            .key("next_since").value(last_seq)
+            .key("has_more").value(has_more)
+            .endObject();
+        res = jsonResponse(json.take());
+        res.end();
     });
 
     CROW_ROUTE(app, "/api/send_text")
     .methods("POST"_method)
-    ([](const crow::request& req){
+    ([](const crow::request& req, crow::response& res){
         auto body = crow::json::load(req.body);
         if (!body || !body.has("text")) {
-            return crow::response(400, "Missing 'text' field");
+            res = crow::response(400, "Missing 'text' field");
+            res.end();
+            return;
         }
         
         std::string text = body["text"].s();
         std::string sender_ip = getClientIP(req);
         
-        std::string msg_id = g_file_manager->addTextMessage(text, sender_ip);
-        
-        crow::json::wvalue notification;
-        notification["type"] = "new_message";
-        notification["message"]["id"] = msg_id;
-        notification["message"]["type"] = "text";
-        notification["message"]["content"] = text;
-        notification["message"]["sender_ip"] = sender_ip;
-        notification["message"]["timestamp"] = g_file_manager->getAllMessages().back().timestamp;
-        
-        broadcastToAllClients(notification.dump());
-        
-        crow::json::wvalue response;
-        response["success"] = true;
-        response["message_id"] = msg_id;
-        return crow::response(response);
+        respondFromDisk(req, res, [text, sender_ip] {
+            auto msg = g_file_manager->addTextMessage(text, sender_ip);
+            if (!msg) {
+                return crow::response(507, "Message history full");
+            }
+            announceMessage(*msg);
+            
+            JsonUtil::Writer json;
+            json.beginObject().key("success").value(true).key("message_id").value(msg->id).endObject();
+            return jsonResponse(json.take());
+        });
     });
 
     CROW_ROUTE(app, "/api/upload")
     .methods("POST"_method)
-    ([](const crow::request& req){
-        crow::multipart::message msg(req);
+    ([](const crow::request& req, crow::response& res){
+        auto upload = std::dynamic_pointer_cast<UploadBodySink>(req.sink);
+        if (!upload) {
+            res = crow::response(400, "No file uploaded");
+            res.end();
+            return;
+        }
         
-        auto file_part = msg.get_part_by_name("file");
-        if (!file_part.body.empty()) {
-            auto headers = file_part.get_header_object("Content-Disposition");
-            std::string filename = headers.params.at("filename");
-            
-            std::string sender_ip = getClientIP(req);
-            std::string msg_id = g_file_manager->addFileMessage(filename, file_part.body, sender_ip);
-            
-            auto messages = g_file_manager->getAllMessages();
-            auto& last_msg = messages.back();
-            
-            crow::json::wvalue notification;
-            notification["type"] = "new_message";
-            notification["message"]["id"] = msg_id;
-            notification["message"]["type"] = "file";
-            notification["message"]["content"] = last_msg.content;
-            notification["message"]["filename"] = last_msg.filename;
-            notification["message"]["filesize"] = last_msg.filesize;
-            notification["message"]["sender_ip"] = sender_ip;
-            notification["message"]["timestamp"] = last_msg.timestamp;
-            
-            broadcastToAllClients(notification.dump());
-            
-            crow::json::wvalue response;
-            response["success"] = true;
-            response["message_id"] = msg_id;
-            response["filename"] = last_msg.filename;
-            return crow::response(response);
+        MultipartStreamParser& parser = upload->parser;
+        if (!parser.finish()) {
+            if (parser.hasError() && parser.hasFile()) {
+                res = crow::response(500, "Upload failed: " + parser.getError());
+            } else {
+                res = crow::response(400, parser.hasError() ? parser.getError() : "No file uploaded");
+            }
+            res.end();
+            return;
         }
         
-        return crow::response(400, "No file uploaded");
+        if (parser.getFileSize() == 0) {
+            res = crow::response(400, "No file uploaded");
+            res.end();
+            return;
+        }
+        
+        // El sink (y con él el staging) vive hasta que la tarea termina
+        std::string sender_ip = getClientIP(req);
+        respondFromDisk(req, res, [upload, sender_ip] {
+            MultipartStreamParser& parser = upload->parser;
+            auto msg = g_file_manager->addFileMessageFromStaging(
+                parser.getFilename(), parser.getStagingPath(), parser.getFileSize(), sender_ip, parser.getDigest());
+            if (!msg) {
+                return crow::response(500, "Cannot store file");
+            }
+            parser.releaseStagingFile();
+            
+            return announceFileMessage(msg);
+        });
     });
 
-    // 🔥 DESCARGA CON STREAMING REAL - SOLUCIÓN
-    CROW_ROUTE(app, "/api/download/<string>")
-    ([](const crow::request& req, crow::response& res, const std::string& filename){
-        std::string file_path = g_file_manager->getFilePath(filename);
-        
-        // Validar existencia
-        if (!g_file_manager->fileExists(filename)) {
-            res.code = 404;
-            res.body = "File not found";
+    // ============================================
+    // Subida reanudable por trozos:
+    //   POST   /api/uploads                {filename, size}  -> upload_id
+    //   PUT    /api/uploads/<id>?offset=N  body = bytes del trozo
+    //   GET    /api/uploads/<id>           intervalos recibidos (para reanudar)
+    //   POST   /api/uploads/<id>/finalize  publica el mensaje
+    //   DELETE /api/uploads/<id>
+    // ============================================
+    CROW_ROUTE(app, "/api/uploads")
+    .methods("POST"_method)
+    ([](const crow::request& req, crow::response& res){
+        auto body = crow::json::load(req.body);
+        if (!body || !body.has("filename") || !body.has("size")) {
+            res = crow::response(400, "Missing 'filename' or 'size'");
             res.end();
             return;
         }
         
-        // Obtener tamaño del archivo
-        struct stat stat_buf;
-        if (stat(file_path.c_str(), &stat_buf) != 0) {
-            res.code = 500;
-            res.body = "Cannot stat file";
+        std::string filename = sanitizeFilename(body["filename"].s());
+        // Un archivo vacío se rechaza igual que en /api/upload
+        if (filename.empty() || body["size"].i() <= 0) {
+            res = crow::response(400, "Invalid 'filename' or 'size'");
             res.end();
             return;
         }
         
-        size_t file_size = stat_buf.st_size;
-        
-        // 📊 Log inicio de descarga
-        std::cout << "⬇️  Iniciando descarga: " << filename 
-                  << " (" << (file_size / 1024.0 / 1024.0) << " MB)" << std::endl;
-        
-        // Configurar headers ANTES de abrir el archivo
-        res.set_header("Content-Type", "application/octet-stream");
-        res.set_header("Content-Disposition", "attachment; filename=\"" + filename + "\"");
-        res.set_header("Content-Length", std::to_string(file_size));
-        res.set_header("Accept-Ranges", "bytes");
-        res.set_header("Cache-Control", "no-cache");
-        res.code = 200;
-        
-        // ✅ STREAMING REAL: Usar stream_response
-        res.set_static_file_info_unsafe(file_path);
+        // open + fallocate del staging
+        size_t size = static_cast<size_t>(body["size"].i());
+        std::string sender_ip = getClientIP(req);
+        respondFromDisk(req, res, [filename, size, sender_ip] {
+            auto session = g_upload_manager->create(filename, size, sender_ip);
+            if (!session) {
+                return crow::response(507, "Cannot allocate upload");
+            }
+            return jsonResponse(uploadStatus(*session), 201);
+        });
+    });
+
+    CROW_ROUTE(app, "/api/uploads/<string>")
+    .methods("PUT"_method, "GET"_method, "DELETE"_method)
+    ([](const crow::request& req, crow::response& res, const std::string& upload_id){
+        if (req.method == "DELETE"_method) {
+            respondFromDisk(req, res, [upload_id] {
+                g_upload_manager->abort(upload_id);  // unlink del staging
+                return crow::response(204);
+            });
+            return;
+        }
         
-        // Alternativa manual si set_static_file_info_unsafe no funciona:
-        /*
-        std::ifstream file(file_path, std::ios::binary);
-        if (!file) {
-            res.code = 500;
-            res.body = "Cannot open file";
+        if (req.method == "GET"_method) {
+            auto session = g_upload_manager->get(upload_id);
+            res = session ? jsonResponse(uploadStatus(*session)) : crow::response(404, "Upload not found");
             res.end();
             return;
         }
         
-        // Chunk de 256KB (óptimo para transferencia)
-        const size_t chunk_size = 262144;
-        std::vector<char> buffer(chunk_size);
+        // PUT: ChunkBodySink ya escribió el trozo en el pool mientras llegaba
+        auto* chunk = dynamic_cast<ChunkBodySink*>(req.sink.get());
+        if (!chunk || !chunk->session) {
+            size_t offset;
+            if (!parseOffset(req.url_params.get("offset"), offset)) {
+                res = crow::response(400, "Missing or invalid 'offset'");
+            } else {
+                res = crow::response(404, "Upload not found");
+            }
+            res.end();
+            return;
+        }
+        if (chunk->result == UploadSession::WriteResult::Conflict) {
+            res = crow::response(409, "Range already received or upload finalized");
+            res.end();
+            return;
+        }
+        if (chunk->result != UploadSession::WriteResult::Ok) {
+            res = crow::response(416, "Chunk outside file bounds or write error");
+            res.end();
+            return;
+        }
         
-        size_t total_sent = 0;
+        auto session = chunk->session;
+        session->markReceived(chunk->offset, chunk->written);
+        // El hash relee con pread lo ya contiguo: en el pool, la respuesta no lo espera
+        g_disk_pool->post([session] { session->advanceHash(); });
         
-        while (file.read(buffer.data(), chunk_size) || file.gcount() > 0) {
-            size_t bytes_read = file.gcount();
-            
-            // ✅ ENVIAR INMEDIATAMENTE cada chunk
-            res.write(buffer.data(), bytes_read);
-            
-            total_sent += bytes_read;
-            
-            // Log progreso cada 10 MB
-            if (total_sent % (10 * 1024 * 1024) == 0 || total_sent == file_size) {
-                std::cout << "📤 Progreso: " 
-                          << (total_sent / 1024.0 / 1024.0) << " / "
-                          << (file_size / 1024.0 / 1024.0) << " MB ("
-                          << (100 * total_sent / file_size) << "%)" << std::endl;
+        JsonUtil::Writer json;
+        json.beginObject()
+            .key("received").value(session->receivedBytes())
+            .key("complete").value(session->receivedBytes() == session->size)
+            .endObject();
+        res = jsonResponse(json.take());
+        res.end();
+    });
+
+    CROW_ROUTE(app, "/api/uploads/<string>/finalize")
+    .methods("POST"_method)
+    ([](const crow::request& req, crow::response& res, const std::string& upload_id){
+        // Sella la sesión (espera a los pwrite en curso), termina de leer el
+        // staging para el hash y lo publica
+        respondFromDisk(req, res, [upload_id] {
+            auto session = g_upload_manager->takeCompleted(upload_id);
+            if (!session) {
+                if (g_upload_manager->get(upload_id)) {
+                    return crow::response(409, "Upload incomplete");
+                }
+                return crow::response(404, "Upload not found");
+            }
+            std::string digest = session->finishHash();
+            if (digest.empty()) {
+                return crow::response(500, "Cannot read upload");
+            }
+            auto msg = g_file_manager->addFileMessageFromStaging(
+                session->filename, session->staging_path, session->size, session->sender_ip, digest);
+            if (!msg) {
+                return crow::response(500, "Cannot store file");
             }
+            session->staging_path.clear();
+            
+            return announceFileMessage(msg);
+        });
+    });
+
+    // ============================================
+    // Subida por hash: POST /api/files/by-hash {sha256, filename, size}
+    // Si el servidor ya tiene ese contenido publica el mensaje sin recibir
+    // ningún byte; 404 si no lo tiene y el cliente debe subirlo.
+    // ============================================
+    CROW_ROUTE(app, "/api/files/by-hash")
+    .methods("POST"_method)
+    ([](const crow::request& req, crow::response& res){
+        auto body = crow::json::load(req.body);
+        if (!body || !body.has("sha256") || !body.has("filename") || !body.has("size")) {
+            res = crow::response(400, "Missing 'sha256', 'filename' or 'size'");
+            res.end();
+            return;
         }
         
-        file.close();
-        std::cout << "✅ Descarga completa: " << filename << std::endl;
-        */
+        std::string sha256 = body["sha256"].s();
+        std::string filename = sanitizeFilename(body["filename"].s());
+        if (!Sha256::isHexDigest(sha256) || filename.empty() || body["size"].i() <= 0) {
+            res = crow::response(400, "Invalid 'sha256', 'filename' or 'size'");
+            res.end();
+            return;
+        }
         
-        res.end();
+        size_t size = static_cast<size_t>(body["size"].i());
+        std::string sender_ip = getClientIP(req);
+        respondFromDisk(req, res, [sha256, filename, size, sender_ip] {
+            auto msg = g_file_manager->addFileMessageFromBlob(filename, sha256, size, sender_ip);
+            if (!msg) {
+                return crow::response(404, "Unknown content");
+            }
+            
+            std::cout << "⚡ Archivo publicado por hash, sin subida: " << filename << std::endl;
+            return announceFileMessage(msg);
+        });
+    });
+
+    // 🔥 DESCARGA ZERO-COPY: open y lectura en el pool de disco, splice al socket sobre
+    // el io_context, con soporte de Range (reanudar y descargar por segmentos en paralelo)
+    CROW_ROUTE(app, "/api/download/<string>")
+    ([](const crow::request& req, crow::response& res, const std::string& filename){
+        // Solo archivos de mensajes (no los .chunked_/.upload_ del staging ni .blobs);
+        // open + fstat en una sola operación (sin carrera entre exists/stat), en el pool de disco
+        g_disk_pool->submit(*req.io_service,
+            [filename]() -> std::shared_ptr<OpenFile> {
+                if (!g_file_manager->touch(filename)) return nullptr;
+                return DownloadEngine::open(g_file_manager->getFilePath(filename));
+            },
+            [&req, &res, filename](std::shared_ptr<OpenFile> file) {
+                startDownload(req, res, filename, std::move(file));
+            });
     });
 
     // ============================================
-    // Rutas estáticas SIN CACHÉ
+    // Rutas estáticas: ETag + 304, precomprimidas; las rutas con huella, inmutables
     // ============================================
     
     CROW_ROUTE(app, "/")
-    ([](){
-        auto* res = Resources::getResource("/index.html");
+    ([](const crow::request& req){
+        auto* res = Resources::getResource("index.html");
         if (res) {
-            auto response = crow::response(res->content);
-            response.set_header("Content-Type", res->mime_type);
-            response.set_header("Cache-Control", "no-cache, no-store, must-revalidate");
-            response.set_header("Pragma", "no-cache");
-            response.set_header("Expires", "0");
-            return response;
+            return resourceResponse(req, *res, false);
         }
         return crow::response(404);
     });
 
     CROW_ROUTE(app, "/<path>")
-    ([](const crow::request&, const std::string& path){
-        std::string resource_path = "/" + path;
-        auto* res = Resources::getResource(resource_path);
+    ([](const crow::request& req, const std::string& path){
+        // Sin concatenar "/": la tabla se consulta con la ruta tal cual
+        auto* entry = Resources::findResource(path);
         
-        if (res) {
-            auto response = crow::response(res->content);
-            response.set_header("Content-Type", res->mime_type);
-            response.set_header("Cache-Control", "no-cache, no-store, must-revalidate");
-            response.set_header("Pragma", "no-cache");
-            response.set_header("Expires", "0");
-            return response;
+        if (entry) {
+            return resourceResponse(req, *entry->resource, entry->fingerprinted);
         }
         
-        return crow::response(404, "Resource not found: " + resource_path);
+        return crow::response(404, "Resource not found: /" + path);
     });
     // ============================================
-    std::cout << "🚀 AutoSync Server iniciando en puerto 8081..." << std::endl;
+    std::cout << "🚀 AutoSync Server iniciando en " << server.bind << ":" << server.port << " con "
+              << server.threads << " hilos de red y " << server.disk_threads << " de disco..." << std::endl;
     std::cout << "📂 Directorio temporal: " << g_file_manager->getTempDir() << std::endl;
-    std::cout << "⚠️  ADVERTENCIA: Todos los archivos se eliminarán al cerrar el servidor" << std::endl;
+    if (!g_file_manager->isPersistent()) {
+        std::cout << "⚠️  ADVERTENCIA: Todos los archivos se eliminarán al cerrar el servidor" << std::endl;
+    }
+    std::string url = "http://localhost:" + std::to_string(server.port);
     std::cout << "\n🌐 Accede desde tu navegador:" << std::endl;
-    std::cout << "   \033]8;;http://localhost:8081\033\\"
-            << "http://localhost:8081"
+    std::cout << "   \033]8;;" << url << "\033\\"
+            << url
             << "\033]8;;\033\\" << std::endl;
 
+    // Hilo i de Crow (los de red y el que acepta conexiones) -> cpus[i % n]
+    if (!server.cpus.empty()) {
+        std::vector<int> cpus = server.cpus;
+        app.thread_init([cpus](uint16_t index) {
+            int cpu = cpus[index % cpus.size()];
+            if (!CpuAffinity::pinCurrentThread(cpu)) {
+                std::cerr << "⚠️  No se pudo fijar el hilo de red " << index << " a la CPU " << cpu << std::endl;
+            }
+        });
+    }
 
-    app.port(8081).multithreaded().run();
+    app.bindaddr(server.bind).port(server.port).concurrency(server.threads).run();
 
+    g_retention->stop();
+    g_upload_manager->stop();
+    g_disk_pool->stop();
     g_file_manager->cleanup();
 
     return 0;
@@ -2,6 +2,7 @@
 let ws = null;
 let reconnectInterval = null;
 let myIP = null;
+let lastSeq = 0;  // último mensaje mostrado: al reconectar solo se pide lo posterior
 
 // Elementos DOM
 const chatContainer = document.getElementById('chatContainer');
@@ -41,10 +42,12 @@ async function getMyIP() {
 // Conectar WebSocket
 function connectWebSocket() {
     const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
-    const wsUrl = `${protocol}//${window.location.host}/ws`;
+    const wsUrl = `${protocol}//${window.location.host}/ws?since=${lastSeq}`;
     
     console.log('🔌 Conectando a:', wsUrl);
-    ws = new WebSocket(wsUrl);
+    // Preferimos el protocolo binario; el servidor elige y lo deja en ws.protocol
+    ws = new WebSocket(wsUrl, ['autosync.v2.bin', 'autosync.v2.json']);
+    ws.binaryType = 'arraybuffer';
     
     ws.onopen = () => {
         console.log('✅ WebSocket conectado');
@@ -59,27 +62,37 @@ function connectWebSocket() {
     
     ws.onmessage = (event) => {
         try {
-            const data = JSON.parse(event.data);
+            const data = typeof event.data === 'string'
+                ? JSON.parse(event.data)
+                : decodeBinaryEvent(event.data);
             console.log('📨 Mensaje recibido:', data);
             
             if (data.type === 'initial_state') {
-                console.log(`📦 Cargando ${data.messages.length} mensajes iniciales`);
-                chatContainer.innerHTML = '';
+                console.log(`📦 Cargando ${data.messages.length} mensajes desde seq ${data.since}`);
+                if (!data.since) {
+                    chatContainer.innerHTML = '';
+                    lastSeq = 0;
+                }
                 
-                data.messages.forEach((msg, index) => {
-                    console.log(`  ${index + 1}. Mensaje:`, msg);
-                    const isMine = isMyMessage(msg);
-                    addMessageToUI(msg, isMine);
-                });
+                data.messages.forEach(showMessage);
                 
                 scrollToBottom();
                 console.log('✅ Mensajes cargados');
                 
             } else if (data.type === 'new_message') {
                 console.log('🆕 Nuevo mensaje:', data.message);
-                const isMine = isMyMessage(data.message);
-                addMessageToUI(data.message, isMine);
+                showMessage(data.message);
                 scrollToBottom();
+                
+            } else if (data.type === 'resync_needed') {
+                // El servidor descartó mensajes porque no leíamos a tiempo
+                console.warn('⚠️ Resincronizando historial desde seq', lastSeq);
+                resyncMessages();
+                
+            } else if (data.type === 'evicted') {
+                // Retención del servidor: historial recortado y archivos borrados
+                removeMessagesBefore(data.first_seq);
+                data.files.forEach(markFileEvicted);
             }
         } catch (error) {
             console.error('❌ Error procesando mensaje WebSocket:', error);
@@ -105,6 +118,127 @@ function connectWebSocket() {
     };
 }
 
+// Decodifica un frame del protocolo binario (formato en src/BinaryProtocol.h)
+// a los mismos objetos que llegan por JSON
+const textDecoder = new TextDecoder();
+
+function decodeBinaryEvent(buffer) {
+    const bytes = new Uint8Array(buffer);
+    let pos = 0;
+    
+    const varint = () => {
+        let value = 0;
+        let scale = 1;
+        let byte;
+        do {
+            byte = bytes[pos++];
+            value += (byte & 0x7f) * scale;
+            scale *= 128;
+        } while (byte & 0x80);
+        return value;
+    };
+    // Cabecera de un mensaje; los largos de sus cadenas quedan en lengths
+    const header = (lengths) => {
+        const end = varint() + pos;
+        const message = { seq: varint() };
+        const isFile = bytes[pos++] === 1;
+        message.type = isFile ? 'file' : 'text';
+        message.id = varint();
+        message.timestamp = varint();
+        if (isFile) message.filesize = varint();
+        for (let i = isFile ? 3 : 2; i > 0; i--) lengths.push(varint());
+        pos = end;  // saltar campos que añadan versiones futuras
+        varint();   // bytes de las cadenas: no hace falta al decodificarlas juntas
+        return message;
+    };
+    
+    // Todas las cadenas del frame con una sola llamada a TextDecoder; los largos
+    // están en unidades UTF-16, así que basta con substring
+    const fillStrings = (messages, lengths) => {
+        const text = textDecoder.decode(bytes.subarray(pos));
+        let offset = 0;
+        let next = 0;
+        const take = () => text.substring(offset, offset += lengths[next++]);
+        for (const message of messages) {
+            message.content = take();
+            message.sender_ip = take();
+            if (message.type === 'file') message.filename = take();
+        }
+    };
+    
+    switch (bytes[pos++]) {
+        case 0x01: {
+            const since = varint();
+            const count = varint();
+            const messages = new Array(count);
+            const lengths = [];
+            for (let i = 0; i < count; i++) messages[i] = header(lengths);
+            fillStrings(messages, lengths);
+            return { type: 'initial_state', since, messages };
+        }
+        case 0x02: {
+            const lengths = [];
+            const message = header(lengths);
+            fillStrings([message], lengths);
+            return { type: 'new_message', message };
+        }
+        case 0x03:
+            return { type: 'resync_needed' };
+        case 0x04: {
+            const first_seq = varint();
+            const count = varint();
+            const files = new Array(count);
+            for (let i = 0; i < count; i++) files[i] = varint();
+            return { type: 'evicted', first_seq, files };
+        }
+        default:
+            throw new Error('Evento binario desconocido: ' + bytes[0]);
+    }
+}
+
+// Pide por HTTP los mensajes posteriores a lastSeq, por páginas
+async function resyncMessages() {
+    try {
+        let hasMore = true;
+        while (hasMore) {
+            const response = await fetch(`/api/messages?since=${lastSeq}&limit=500`);
+            if (!response.ok) {
+                throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+            }
+            const data = await response.json();
+            data.messages.forEach(showMessage);
+            hasMore = data.has_more && data.messages.length > 0;
+        }
+        scrollToBottom();
+    } catch (error) {
+        console.error('❌ Error al resincronizar:', error);
+    }
+}
+
+// Muestra un mensaje una sola vez aunque llegue por initial_state y por broadcast
+function showMessage(message) {
+    if (message.seq <= lastSeq) return;
+    lastSeq = message.seq;
+    addMessageToUI(message, isMyMessage(message));
+}
+
+// Quita del chat los mensajes que el servidor ya no conserva
+function removeMessagesBefore(firstSeq) {
+    chatContainer.querySelectorAll('.message[data-seq]').forEach(element => {
+        if (Number(element.dataset.seq) < firstSeq) element.remove();
+    });
+}
+
+// El mensaje sigue, pero su archivo ya no se puede descargar
+function markFileEvicted(messageId) {
+    const element = chatContainer.querySelector(`.message[data-message-id="${CSS.escape(String(messageId))}"]`);
+    const button = element?.querySelector('.download-btn');
+    if (!button) return;
+    button.disabled = true;
+    button.textContent = '🗑️ Expirado';
+    button.title = 'El servidor eliminó este archivo';
+}
+
 // Determinar si un mensaje es mío
 function isMyMessage(message) {
     if (!myIP || !message.sender_ip) {
@@ -232,6 +366,7 @@ function addMessageToUI(message, isSent) {
         const messageDiv = document.createElement('div');
         messageDiv.className = `message ${isSent ? 'sent' : 'received'}`;
         messageDiv.setAttribute('data-message-id', message.id);
+        messageDiv.setAttribute('data-seq', message.seq);
         
         const wrapper = document.createElement('div');
         wrapper.className = 'message-wrapper';
@@ -342,25 +477,224 @@ async function sendTextMessage() {
     }
 }
 
+// Archivos grandes: subida por trozos paralelos y reanudable
+const CHUNKED_UPLOAD_THRESHOLD = 8 * 1024 * 1024;
+const UPLOAD_CONCURRENCY = 4;
+const CHUNK_RETRIES = 5;
+
+function uploadResumeKey(file) {
+    return `upload:${file.name}:${file.size}:${file.lastModified}`;
+}
+
+// Reutiliza la sesión guardada si el servidor aún la tiene; si no, crea una nueva
+async function openUploadSession(file) {
+    const key = uploadResumeKey(file);
+    const savedId = localStorage.getItem(key);
+    
+    if (savedId) {
+        const response = await fetch(`/api/uploads/${savedId}`);
+        if (response.ok) {
+            console.log('🔄 Reanudando subida:', file.name);
+            return await response.json();
+        }
+        localStorage.removeItem(key);
+    }
+    
+    const response = await fetch('/api/uploads', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ filename: file.name, size: file.size })
+    });
+    if (!response.ok) {
+        throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+    }
+    
+    const session = await response.json();
+    localStorage.setItem(key, session.upload_id);
+    return session;
+}
+
+// Trozos [inicio, fin) que faltan según los intervalos ya recibidos
+function missingChunks(size, chunkSize, ranges) {
+    const chunks = [];
+    for (let start = 0; start < size; start += chunkSize) {
+        const end = Math.min(start + chunkSize, size);
+        const done = ranges.some(([first, last]) => first <= start && last >= end);
+        if (!done) chunks.push([start, end]);
+    }
+    return chunks;
+}
+
+async function putChunk(uploadId, file, start, end, signal) {
+    for (let attempt = 1; ; attempt++) {
+        try {
+            const response = await fetch(`/api/uploads/${uploadId}?offset=${start}`, {
+                method: 'PUT',
+                body: file.slice(start, end),
+                signal
+            });
+            // 409: el servidor ya tiene ese rango (un intento anterior llegó
+            // aunque se perdiera la respuesta); finalize dirá si falta algo
+            if (response.ok || response.status === 409) return;
+            if (response.status < 500 || attempt >= CHUNK_RETRIES) {
+                throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+            }
+        } catch (error) {
+            if (signal && signal.aborted) throw error;
+            if (attempt >= CHUNK_RETRIES) throw error;
+            console.warn(`⚠️ Trozo ${start}-${end} falló (intento ${attempt}), reintentando...`);
+        }
+        await new Promise(resolve => setTimeout(resolve, 1000 * attempt));
+    }
+}
+
+async function uploadFileChunked(file, signal) {
+    const session = await openUploadSession(file);
+    const queue = missingChunks(file.size, session.chunk_size, session.ranges);
+    
+    const worker = async () => {
+        while (queue.length > 0) {
+            const [start, end] = queue.shift();
+            await putChunk(session.upload_id, file, start, end, signal);
+        }
+    };
+    try {
+        await Promise.all(Array.from({ length: UPLOAD_CONCURRENCY }, worker));
+    } catch (error) {
+        if (signal && signal.aborted) {
+            // El servidor ya tenía el contenido: la sesión sobra
+            queue.length = 0;
+            localStorage.removeItem(uploadResumeKey(file));
+            fetch(`/api/uploads/${session.upload_id}`, { method: 'DELETE' }).catch(() => {});
+        }
+        throw error;
+    }
+    
+    const response = await fetch(`/api/uploads/${session.upload_id}/finalize`, { method: 'POST' });
+    if (!response.ok) {
+        throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+    }
+    localStorage.removeItem(uploadResumeKey(file));
+    return await response.json();
+}
+
+async function uploadFileForm(file, signal) {
+    const formData = new FormData();
+    formData.append('file', file);
+    
+    const response = await fetch('/api/upload', {
+        method: 'POST',
+        body: formData,
+        signal
+    });
+    
+    if (!response.ok) {
+        throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+    }
+    return await response.json();
+}
+
+// Archivos más pequeños se suben sin más: el hash no ahorraría nada
+const HASH_PRECHECK_MIN_SIZE = 1024 * 1024;
+
+// SHA-256 en un Web Worker (js/hash-worker.js): no bloquea la página
+const hashWorker = (() => {
+    if (!window.Worker) return null;
+    
+    const worker = new Worker('/js/hash-worker.js');
+    const pending = new Map();
+    let nextId = 1;
+    
+    worker.onmessage = (event) => {
+        const { id, sha256, error } = event.data;
+        const request = pending.get(id);
+        if (!request) return;
+        pending.delete(id);
+        if (sha256) request.resolve(sha256);
+        else request.reject(new Error(error));
+    };
+    
+    return {
+        // { promise, cancel }: cancel() libera al worker si el hash ya no hace falta
+        hash(file) {
+            const id = nextId++;
+            const promise = new Promise((resolve, reject) => pending.set(id, { resolve, reject }));
+            worker.postMessage({ id, file });
+            return {
+                promise,
+                cancel: () => {
+                    pending.delete(id);
+                    worker.postMessage({ cancel: id });
+                }
+            };
+        }
+    };
+})();
+
+// Publica el archivo a partir de su hash si el servidor ya tiene ese contenido;
+// null si hay que subirlo
+async function publishByHash(file, sha256) {
+    const response = await fetch('/api/files/by-hash', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ sha256, filename: file.name, size: file.size })
+    });
+    if (response.status === 404) return null;
+    if (!response.ok) {
+        throw new Error(`HTTP ${response.status}: ${response.statusText}`);
+    }
+    return await response.json();
+}
+
+function uploadFile(file, signal) {
+    return file.size > CHUNKED_UPLOAD_THRESHOLD
+        ? uploadFileChunked(file, signal)
+        : uploadFileForm(file, signal);
+}
+
+// La subida empieza enseguida y el hash se calcula a la vez; si el servidor
+// ya tiene el contenido, la subida se cancela y el mensaje se crea sin más bytes
+async function uploadOrPublishByHash(file, digest) {
+    if (!digest) return uploadFile(file);
+    
+    const controller = new AbortController();
+    let settled = false;
+    let published = null;
+    
+    digest.promise.then(async (sha256) => {
+        if (settled) return;
+        published = await publishByHash(file, sha256);
+        if (published && !settled) {
+            console.log('⚡ Contenido ya en el servidor, sin subir:', file.name);
+            controller.abort();
+        }
+    }).catch((error) => console.warn('⚠️ Comprobación por hash fallida:', error));
+    
+    try {
+        const data = await uploadFile(file, controller.signal);
+        settled = true;
+        digest.cancel();
+        return data;
+    } catch (error) {
+        settled = true;
+        if (published) return published;
+        digest.cancel();
+        throw error;
+    }
+}
+
 // Subir archivos
 async function uploadFiles(files) {
-    for (const file of files) {
+    // Todos los hashes se encargan ya: los de los siguientes archivos avanzan
+    // mientras se sube el primero
+    const digests = files.map(file =>
+        hashWorker && file.size >= HASH_PRECHECK_MIN_SIZE ? hashWorker.hash(file) : null);
+    
+    for (const [index, file] of files.entries()) {
         console.log('📤 Subiendo archivo:', file.name);
         
-        const formData = new FormData();
-        formData.append('file', file);
-        
         try {
-            const response = await fetch('/api/upload', {
-                method: 'POST',
-                body: formData
-            });
-            
-            if (!response.ok) {
-                throw new Error(`HTTP ${response.status}: ${response.statusText}`);
-            }
-            
-            const data = await response.json();
+            const data = await uploadOrPublishByHash(file, digests[index]);
             if (data.success) {
                 console.log('✅ Archivo subido:', data.filename);
             }
@@ -378,30 +712,55 @@ async function downloadFile(filename, originalName) {
     downloadBtn.disabled = true;
     
     try {
-        const response = await fetch(`/api/download/${filename}`);
-        
-        if (!response.ok) {
-            throw new Error(`HTTP error! status: ${response.status}`);
-        }
-        
-        const contentLength = response.headers.get('Content-Length');
-        const total = parseInt(contentLength, 10);
-        
-        const reader = response.body.getReader();
         const chunks = [];
         let receivedLength = 0;
-        
-        while (true) {
-            const { done, value } = await reader.read();
-            
-            if (done) break;
-            
-            chunks.push(value);
-            receivedLength += value.length;
+        let total = 0;
+        let etag = null;
+        
+        // Si la conexión se corta, se reanuda desde el último byte recibido
+        // con Range + If-Range (el servidor responde 200 si el archivo cambió)
+        for (let attempt = 0; ; attempt++) {
+            const headers = {};
+            if (receivedLength > 0 && etag) {
+                headers['Range'] = `bytes=${receivedLength}-`;
+                headers['If-Range'] = etag;
+            }
             
-            if (total) {
-                const percent = Math.round((receivedLength / total) * 100);
-                downloadBtn.textContent = `${percent}%`;
+            try {
+                const response = await fetch(`/api/download/${filename}`, { headers });
+                
+                if (response.status === 200) {
+                    // Completo (primera vez, o el archivo cambió): empezar de cero
+                    chunks.length = 0;
+                    receivedLength = 0;
+                    total = parseInt(response.headers.get('Content-Length'), 10);
+                } else if (response.status !== 206) {
+                    throw new Error(`HTTP error! status: ${response.status}`);
+                }
+                etag = response.headers.get('ETag');
+                
+                const reader = response.body.getReader();
+                
+                while (true) {
+                    const { done, value } = await reader.read();
+                    
+                    if (done) break;
+                    
+                    chunks.push(value);
+                    receivedLength += value.length;
+                    
+                    if (total) {
+                        const percent = Math.round((receivedLength / total) * 100);
+                        downloadBtn.textContent = `${percent}%`;
+                    }
+                }
+                
+                if (!total || receivedLength >= total) break;
+                throw new Error('Conexión cerrada antes de terminar');
+            } catch (error) {
+                if (attempt >= 5 || !etag || error.message.startsWith('HTTP error')) throw error;
+                console.warn(`⚠️ Descarga interrumpida en ${receivedLength} bytes, reanudando...`, error);
+                await new Promise(resolve => setTimeout(resolve, 1000 * (attempt + 1)));
             }
         }
         
@@ -435,6 +794,7 @@ async function downloadFile(filename, originalName) {
 }
 
 // Utilidades
+// timestamp: epoch en ms, tal como lo envía el servidor
 function formatTime(timestamp) {
     try {
         const date = new Date(timestamp);
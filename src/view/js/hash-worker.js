@@ -0,0 +1,170 @@
+// ============================================
+// SHA-256 de archivos en segundo plano (Web Worker)
+// ============================================
+// crypto.subtle.digest necesita el archivo entero en memoria; aquí se lee por
+// trozos y el hash avanza de forma incremental, así que vale para archivos de
+// varios GB sin bloquear la página.
+//
+//   → { id, file }      calcula el hash (los archivos se procesan en orden)
+//   → { cancel: id }    abandona un hash pendiente o en curso
+//   ← { id, sha256 }    o { id, error }
+
+const READ_SIZE = 4 * 1024 * 1024;
+
+const K = new Int32Array([
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+]);
+
+class Sha256 {
+    constructor() {
+        this.state = new Int32Array([
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        ]);
+        this.w = new Int32Array(64);
+        this.pending = new Uint8Array(64);  // bloque incompleto del update anterior
+        this.pendingLength = 0;
+        this.total = 0;
+    }
+
+    update(bytes) {
+        this.total += bytes.length;
+        let pos = 0;
+
+        if (this.pendingLength > 0) {
+            const take = Math.min(64 - this.pendingLength, bytes.length);
+            this.pending.set(bytes.subarray(0, take), this.pendingLength);
+            this.pendingLength += take;
+            pos = take;
+            if (this.pendingLength < 64) return;
+            this.blocks(this.pending, 0, 64);
+            this.pendingLength = 0;
+        }
+
+        // En tramos de 64 KB: V8 optimiza blocks() enseguida en lugar de
+        // interpretar un trozo entero de varios MB
+        const end = pos + ((bytes.length - pos) & ~63);
+        for (let start = pos; start < end; start += 65536) {
+            this.blocks(bytes, start, Math.min(start + 65536, end));
+        }
+        this.pending.set(bytes.subarray(end), 0);
+        this.pendingLength = bytes.length - end;
+    }
+
+    finish() {
+        const bits = this.total * 8;
+        const padding = new Uint8Array((this.pendingLength < 56 ? 56 : 120) - this.pendingLength + 8);
+        padding[0] = 0x80;
+        // Longitud en bits, big-endian (hasta 2^53: suficiente para cualquier archivo)
+        const view = new DataView(padding.buffer);
+        view.setUint32(padding.length - 8, Math.floor(bits / 0x100000000));
+        view.setUint32(padding.length - 4, bits >>> 0);
+        this.update(padding);
+
+        let hex = '';
+        for (const word of this.state) {
+            hex += (word >>> 0).toString(16).padStart(8, '0');
+        }
+        return hex;
+    }
+
+    // Bloques de 64 bytes en bytes[start, end)
+    blocks(bytes, start, end) {
+        const w = this.w;
+        const state = this.state;
+        let h0 = state[0], h1 = state[1], h2 = state[2], h3 = state[3];
+        let h4 = state[4], h5 = state[5], h6 = state[6], h7 = state[7];
+
+        for (let offset = start; offset < end; offset += 64) {
+            for (let i = 0; i < 16; i++) {
+                const p = offset + i * 4;
+                w[i] = (bytes[p] << 24) | (bytes[p + 1] << 16) | (bytes[p + 2] << 8) | bytes[p + 3];
+            }
+            for (let i = 16; i < 64; i++) {
+                const x = w[i - 15];
+                const y = w[i - 2];
+                const s0 = ((x >>> 7) | (x << 25)) ^ ((x >>> 18) | (x << 14)) ^ (x >>> 3);
+                const s1 = ((y >>> 17) | (y << 15)) ^ ((y >>> 19) | (y << 13)) ^ (y >>> 10);
+                w[i] = (w[i - 16] + s0 + w[i - 7] + s1) | 0;
+            }
+
+            let a = h0, b = h1, c = h2, d = h3, e = h4, f = h5, g = h6, h = h7;
+            for (let i = 0; i < 64; i++) {
+                const S1 = ((e >>> 6) | (e << 26)) ^ ((e >>> 11) | (e << 21)) ^ ((e >>> 25) | (e << 7));
+                const t1 = (h + S1 + ((e & f) ^ (~e & g)) + K[i] + w[i]) | 0;
+                const S0 = ((a >>> 2) | (a << 30)) ^ ((a >>> 13) | (a << 19)) ^ ((a >>> 22) | (a << 10));
+                const t2 = (S0 + ((a & b) ^ (a & c) ^ (b & c))) | 0;
+                h = g;
+                g = f;
+                f = e;
+                e = (d + t1) | 0;
+                d = c;
+                c = b;
+                b = a;
+                a = (t1 + t2) | 0;
+            }
+
+            h0 = (h0 + a) | 0; h1 = (h1 + b) | 0; h2 = (h2 + c) | 0; h3 = (h3 + d) | 0;
+            h4 = (h4 + e) | 0; h5 = (h5 + f) | 0; h6 = (h6 + g) | 0; h7 = (h7 + h) | 0;
+        }
+
+        state[0] = h0; state[1] = h1; state[2] = h2; state[3] = h3;
+        state[4] = h4; state[5] = h5; state[6] = h6; state[7] = h7;
+    }
+}
+
+const queue = [];
+const cancelled = new Set();
+let running = false;
+let current = null;
+
+async function hashFile(id, file) {
+    const hasher = new Sha256();
+    // La lectura del siguiente trozo se solapa con el hash del actual
+    let next = file.slice(0, READ_SIZE).arrayBuffer();
+    for (let offset = 0; offset < file.size; offset += READ_SIZE) {
+        const buffer = await next;
+        if (cancelled.has(id)) return null;
+        if (offset + READ_SIZE < file.size) {
+            next = file.slice(offset + READ_SIZE, offset + 2 * READ_SIZE).arrayBuffer();
+        }
+        hasher.update(new Uint8Array(buffer));
+    }
+    return hasher.finish();
+}
+
+async function run() {
+    if (running) return;
+    running = true;
+    while (queue.length > 0) {
+        const { id, file } = queue.shift();
+        if (cancelled.delete(id)) continue;
+        current = id;
+        try {
+            const sha256 = await hashFile(id, file);
+            if (!cancelled.delete(id)) self.postMessage({ id, sha256 });
+        } catch (error) {
+            cancelled.delete(id);
+            self.postMessage({ id, error: error.message });
+        }
+        current = null;
+    }
+    running = false;
+}
+
+self.onmessage = (event) => {
+    const { id, file, cancel } = event.data;
+    if (cancel !== undefined) {
+        // Un hash ya terminado no necesita marca
+        if (cancel === current || queue.some(item => item.id === cancel)) cancelled.add(cancel);
+        return;
+    }
+    queue.push({ id, file });
+    run();
+};
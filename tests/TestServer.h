@@ -0,0 +1,220 @@
+#ifndef TEST_SERVER_H
+#define TEST_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Utilidades comunes de las pruebas de tests/ que hablan con el servidor:
+// arrancan una copia en un directorio temporal (temp_shared queda junto al
+// ejecutable) y hacen peticiones HTTP en crudo por 127.0.0.1.
+namespace TestServer {
+
+namespace fs = std::filesystem;
+
+inline pid_t server_pid = -1;
+inline uint16_t server_port = 0;
+inline int failures = 0;
+
+inline uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+inline int connectServer() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    timeval timeout{10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+inline bool serverAlive() {
+    int status;
+    return server_pid > 0 && waitpid(server_pid, &status, WNOHANG) == 0;
+}
+
+// Copia el servidor a un directorio temporal y lo arranca; dir queda con la
+// ruta para stop(). false si no llega a aceptar conexiones.
+inline bool start(const char* server_binary, fs::path& dir) {
+    char dir_template[] = "/tmp/autosync_test_XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        perror("mkdtemp");
+        return false;
+    }
+    dir = dir_template;
+    fs::path binary = dir / "auto_sync_server";
+    fs::copy_file(server_binary, binary);
+    fs::permissions(binary, fs::perms::owner_all);
+
+    server_port = freePort();
+    std::string port_arg = "--port=" + std::to_string(server_port);
+    server_pid = fork();
+    if (server_pid == 0) {
+        int log = open((dir / "server.log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        execl(binary.c_str(), binary.c_str(), port_arg.c_str(), "--bind=127.0.0.1",
+              "--threads=2", "--disk-threads=2", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    for (int i = 0; i < 100 && serverAlive(); i++) {
+        int fd = connectServer();
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::cerr << "❌ El servidor no arrancó (ver " << (dir / "server.log") << ")" << std::endl;
+    return false;
+}
+
+// Para el servidor y devuelve el código de salida de la prueba; el directorio
+// solo se conserva (con el registro) si algo falló
+inline int stop(const fs::path& dir) {
+    if (serverAlive()) {
+        kill(server_pid, SIGTERM);
+        int status;
+        waitpid(server_pid, &status, 0);
+    }
+    if (failures == 0) {
+        fs::remove_all(dir);
+    } else {
+        std::cerr << "Registro del servidor en " << (dir / "server.log") << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Envía una petición con Connection: close y devuelve la respuesta completa (hasta EOF).
+// headers: líneas extra ya terminadas en \r\n
+inline std::string request(const std::string& method, const std::string& path,
+                           const std::string& body = "", const std::string& content_type = "application/json",
+                           const std::string& headers = "") {
+    int fd = connectServer();
+    if (fd < 0) return "";
+    std::string raw = method + " " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n" + headers;
+    if (!body.empty() || method == "POST" || method == "PUT") {
+        raw += "Content-Type: " + content_type + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    raw += "\r\n" + body;
+    send(fd, raw.data(), raw.size(), MSG_NOSIGNAL);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, n);
+    close(fd);
+    return response;
+}
+
+// Petición keep-alive: lee solo las cabeceras y cierra
+inline std::string requestHeaders(const std::string& path) {
+    int fd = connectServer();
+    if (fd < 0) return "";
+    std::string raw = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(fd, raw.data(), raw.size(), MSG_NOSIGNAL);
+
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while (response.find("\r\n\r\n") == std::string::npos && (n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, n);
+    }
+    close(fd);
+    return response.substr(0, response.find("\r\n\r\n") + 2);
+}
+
+// Cabeceras con ese nombre (sin distinguir mayúsculas)
+inline int headerCount(const std::string& headers, const std::string& name) {
+    int count = 0;
+    size_t start = 0;
+    while ((start = headers.find("\r\n", start)) != std::string::npos) {
+        start += 2;
+        if (strncasecmp(headers.c_str() + start, (name + ":").c_str(), name.size() + 1) == 0) count++;
+    }
+    return count;
+}
+
+// Valor de la primera cabecera con ese nombre; "" si no está
+inline std::string headerValue(const std::string& response, const std::string& name) {
+    size_t end = response.find("\r\n\r\n");
+    size_t start = 0;
+    while ((start = response.find("\r\n", start)) != std::string::npos && start < end) {
+        start += 2;
+        if (strncasecmp(response.c_str() + start, (name + ":").c_str(), name.size() + 1) == 0) {
+            size_t value = response.find_first_not_of(' ', start + name.size() + 1);
+            return response.substr(value, response.find("\r\n", value) - value);
+        }
+    }
+    return "";
+}
+
+inline std::string bodyOf(const std::string& response) {
+    size_t end = response.find("\r\n\r\n");
+    return end == std::string::npos ? "" : response.substr(end + 4);
+}
+
+inline int statusOf(const std::string& response) {
+    return response.size() > 12 ? std::atoi(response.c_str() + 9) : 0;
+}
+
+// Valor de "key":"..." en el cuerpo JSON
+inline std::string jsonString(const std::string& response, const std::string& key) {
+    std::string pattern = "\"" + key + "\":\"";
+    size_t start = response.find(pattern);
+    if (start == std::string::npos) return "";
+    start += pattern.size();
+    return response.substr(start, response.find('"', start) - start);
+}
+
+// Comprueba el código de estado y que el servidor siga vivo
+inline std::string check(const std::string& name, int expected, const std::string& response) {
+    int status = statusOf(response);
+    // El servidor recibe la señal en otro proceso: se le deja un momento para caer
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool alive = serverAlive();
+    bool ok = status == expected && alive;
+    std::cout << (ok ? "ok   " : "FAIL ") << name << ": " << status
+              << (alive ? "" : " (el servidor ha terminado)") << std::endl;
+    if (!ok) failures++;
+    return response;
+}
+
+// Comprobación sin petición de por medio
+inline void expect(const std::string& name, bool ok, const std::string& detail = "") {
+    std::cout << (ok ? "ok   " : "FAIL ") << name << (detail.empty() ? "" : ": " + detail) << std::endl;
+    if (!ok) failures++;
+}
+
+} // namespace TestServer
+
+#endif
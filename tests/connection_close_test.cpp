@@ -0,0 +1,102 @@
+// Regresión: las rutas que terminan la respuesta desde el pool de disco no
+// deben usar la conexión después de que Crow la destruya. Con "Connection: close"
+// Crow deja de leer en cuanto llega la petición; antes eso liberaba la conexión
+// mientras el handler aún tenía su crow::response (double free, el proceso moría).
+//
+// Uso: connection_close_test <ruta a auto_sync_server>
+// Arranca una copia del servidor en un directorio temporal (temp_shared queda
+// junto al ejecutable) y hace cada petición con Connection: close.
+
+#include "TestServer.h"
+
+using namespace TestServer;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "uso: " << argv[0] << " <auto_sync_server>" << std::endl;
+        return 2;
+    }
+
+    fs::path dir;
+    if (!start(argv[1], dir)) return 1;
+
+    const std::string content = "autosync\n";
+    const std::string sha256 = "caa9603a5bca6cb488c8e8f78c21cd9071e8c97ba36082c7d9ef573ef708aded";
+
+    check("POST /api/send_text", 200, request("POST", "/api/send_text", "{\"text\":\"hi\"}"));
+
+    std::string multipart = "--b\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                            "Content-Type: text/plain\r\n\r\n" + content + "\r\n--b--\r\n";
+    std::string uploaded = check("POST /api/upload", 200,
+                                 request("POST", "/api/upload", multipart, "multipart/form-data; boundary=b"));
+    std::string stored_name = jsonString(uploaded, "filename");
+
+    check("POST /api/files/by-hash", 200, request("POST", "/api/files/by-hash",
+          "{\"sha256\":\"" + sha256 + "\",\"filename\":\"b.txt\",\"size\":" + std::to_string(content.size()) + "}"));
+
+    std::string created = check("POST /api/uploads", 201, request("POST", "/api/uploads",
+                                "{\"filename\":\"c.txt\",\"size\":" + std::to_string(content.size()) + "}"));
+    std::string upload_id = jsonString(created, "upload_id");
+    check("PUT /api/uploads/<id>", 200,
+          request("PUT", "/api/uploads/" + upload_id + "?offset=0", content, "application/octet-stream"));
+    // Un rango ya recibido no se reescribe: podría estar ya en el hash
+    check("PUT /api/uploads/<id> (repetido)", 409,
+          request("PUT", "/api/uploads/" + upload_id + "?offset=0", content, "application/octet-stream"));
+    check("POST /api/uploads/<id>/finalize", 200, request("POST", "/api/uploads/" + upload_id + "/finalize"));
+
+    // Solo se sirven archivos de mensajes: ni el staging de una subida ni los blobs
+    std::string pending = jsonString(request("POST", "/api/uploads", "{\"filename\":\"e.txt\",\"size\":1}"), "upload_id");
+    check("GET /api/download/.chunked_<id>", 404, request("GET", "/api/download/.chunked_" + pending));
+    check("GET /api/download/.blobs", 404, request("GET", "/api/download/.blobs"));
+
+    // Sin contenido no hay mensaje de archivo, como en POST /api/upload
+    check("POST /api/uploads (size 0)", 400, request("POST", "/api/uploads", "{\"filename\":\"z.txt\",\"size\":0}"));
+    check("POST /api/files/by-hash (size 0)", 400, request("POST", "/api/files/by-hash",
+          "{\"sha256\":\"" + sha256 + "\",\"filename\":\"z.txt\",\"size\":0}"));
+
+    std::string aborted = jsonString(request("POST", "/api/uploads", "{\"filename\":\"d.txt\",\"size\":1}"), "upload_id");
+    check("DELETE /api/uploads/<id>", 204, request("DELETE", "/api/uploads/" + aborted));
+
+    // Bodies mucho mayores que la cola de los sinks (128 KB): la lectura se pausa mientras
+    // el pool escribe, y el archivo tiene que llegar entero y en orden
+    std::string large(3 * 1024 * 1024 + 123, '\0');
+    uint32_t seed = 1;
+    for (char& c : large) {
+        seed = seed * 1103515245 + 12345;
+        c = static_cast<char>(seed >> 24);
+    }
+    std::string large_multipart = "--autosync-boundary\r\nContent-Disposition: form-data; name=\"file\"; filename=\"big.bin\"\r\n"
+                                  "Content-Type: application/octet-stream\r\n\r\n" + large + "\r\n--autosync-boundary--\r\n";
+    std::string big_uploaded = check("POST /api/upload (3 MB)", 200, request("POST", "/api/upload", large_multipart,
+                                     "multipart/form-data; boundary=autosync-boundary"));
+    std::string big_id = jsonString(check("POST /api/uploads (3 MB)", 201, request("POST", "/api/uploads",
+                                          "{\"filename\":\"big2.bin\",\"size\":" + std::to_string(large.size()) + "}")), "upload_id");
+    check("PUT /api/uploads/<id> (3 MB)", 200,
+          request("PUT", "/api/uploads/" + big_id + "?offset=0", large, "application/octet-stream"));
+    std::string big_finalized = check("POST /api/uploads/<id>/finalize (3 MB)", 200,
+                                      request("POST", "/api/uploads/" + big_id + "/finalize"));
+    for (const std::string& name : {jsonString(big_uploaded, "filename"), jsonString(big_finalized, "filename")}) {
+        bool same = bodyOf(request("GET", "/api/download/" + name)) == large;
+        expect("GET /api/download/" + name, same, same ? "mismo contenido" : "contenido distinto");
+    }
+
+    check("GET /api/download/<name>", 200, request("GET", "/api/download/" + stored_name));
+    std::string headers = requestHeaders("/api/download/" + stored_name);
+    int connection_headers = headerCount(headers, "Connection");
+    expect("GET /api/download/<name> (keep-alive)", connection_headers == 1,
+           std::to_string(connection_headers) + " cabecera(s) Connection");
+    check("GET /api/download/<missing>", 404, request("GET", "/api/download/missing.txt"));
+
+    // HTTP/1.0 también cierra la conexión tras la respuesta
+    int fd = connectServer();
+    std::string raw = "POST /api/send_text HTTP/1.0\r\nContent-Type: application/json\r\nContent-Length: 13\r\n\r\n{\"text\":\"hi\"}";
+    send(fd, raw.data(), raw.size(), MSG_NOSIGNAL);
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, n);
+    close(fd);
+    check("POST /api/send_text (HTTP/1.0)", 200, response);
+
+    return stop(dir);
+}
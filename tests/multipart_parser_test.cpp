@@ -0,0 +1,232 @@
+// MultipartStreamParser con el body partido en cualquier punto: el boundary
+// puede quedar repartido entre dos feed(), igual que el CRLF que lo precede,
+// y el resultado (archivo de staging, tamaño y SHA-256) no debe cambiar.
+//
+// Uso: multipart_parser_test
+// Los stagings se crean en un directorio temporal que se borra al terminar.
+
+#include "MultipartStreamParser.h"
+#include "Sha256.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string CONTENT_TYPE = "multipart/form-data; boundary=XYZ";
+
+int failures = 0;
+std::string staging_dir;
+
+void expect(const std::string& name, bool ok, const std::string& detail = "") {
+    std::cout << (ok ? "ok   " : "FAIL ") << name << (detail.empty() ? "" : ": " + detail) << std::endl;
+    if (!ok) failures++;
+}
+
+std::string sha256(const std::string& data) {
+    Sha256 hasher;
+    hasher.update(data.data(), data.size());
+    return hasher.finish();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+size_t stagingCount() {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(staging_dir)) {
+        (void)entry;
+        count++;
+    }
+    return count;
+}
+
+// Contenido con todo lo que se parece a un delimitador sin serlo: el boundary
+// sin CRLF delante, prefijos de "\r\n--XYZ" y CRLF al principio y al final
+std::string trickyContent() {
+    static const char text[] = "\r\nprimera línea\r\n--XY\r\n-\r\n\r\n--X"
+                               "--XYZ sin CRLF delante\r\n\r--XYZ\n--XYZ"
+                               "\0binario\xff\xfe\r\n";
+    return std::string(text, sizeof(text) - 1);
+}
+
+// Body con un campo de texto, el archivo y un segundo archivo que se ignora
+std::string makeBody(const std::string& content, bool with_preamble) {
+    std::string body;
+    if (with_preamble) {
+        body += "Preámbulo que se ignora, con --XYZ en medio\r\n--XY\r\n";
+    }
+    body += "--XYZ\r\n"
+            "Content-Disposition: form-data; name=\"comment\"\r\n\r\n"
+            "texto con \r\n--XY dentro"
+            "\r\n--XYZ\r\n"
+            "Content-Disposition: form-data; name=\"file\"; filename=\"C:\\fotos\\prueba.bin\"\r\n"
+            "Content-Type: application/octet-stream\r\n\r\n" + content +
+            "\r\n--XYZ\r\n"
+            "Content-Disposition: form-data; name=\"file\"; filename=\"otro.bin\"\r\n\r\n"
+            "segundo archivo"
+            "\r\n--XYZ--";
+    if (with_preamble) {
+        body += "\r\nEpílogo que se ignora\r\n--XYZ\r\nbasura";
+    }
+    return body;
+}
+
+// Parsea body entregándolo en los trozos que marcan cuts (posiciones crecientes)
+// y devuelve "" si el resultado es el esperado, o qué falló
+std::string parse(const std::string& body, const std::vector<size_t>& cuts, const std::string& content) {
+    std::string problem;
+    {
+        MultipartStreamParser parser(CONTENT_TYPE, staging_dir);
+        size_t start = 0;
+        for (size_t cut : cuts) {
+            parser.feed(body.data() + start, cut - start);
+            start = cut;
+        }
+        parser.feed(body.data() + start, body.size() - start);
+
+        if (!parser.finish()) {
+            problem = "finish() falló: " + parser.getError();
+        } else if (parser.getFilename() != "prueba.bin") {
+            problem = "nombre " + parser.getFilename();
+        } else if (parser.getFileSize() != content.size()) {
+            problem = "tamaño " + std::to_string(parser.getFileSize());
+        } else if (readFile(parser.getStagingPath()) != content) {
+            problem = "contenido distinto en el staging";
+        } else if (parser.getDigest() != sha256(content)) {
+            problem = "digest " + parser.getDigest();
+        }
+    }
+    // Sin releaseStagingFile() el destructor borra el staging
+    if (problem.empty() && stagingCount() != 0) problem = "el staging no se borró";
+    return problem;
+}
+
+void testEverySplit(const std::string& name, const std::string& body, const std::string& content) {
+    std::string first_problem;
+    size_t failed = 0;
+    for (size_t split = 0; split <= body.size(); split++) {
+        std::string problem = parse(body, {split}, content);
+        if (!problem.empty() && failed++ == 0) {
+            first_problem = "corte en " + std::to_string(split) + ": " + problem;
+        }
+    }
+    expect(name + ", cada punto de corte (" + std::to_string(body.size() + 1) + ")", failed == 0,
+           failed == 0 ? "" : std::to_string(failed) + " fallos; " + first_problem);
+}
+
+void testByteByByte(const std::string& name, const std::string& body, const std::string& content) {
+    std::vector<size_t> cuts;
+    for (size_t i = 1; i < body.size(); i++) cuts.push_back(i);
+    std::string problem = parse(body, cuts, content);
+    expect(name + ", byte a byte", problem.empty(), problem);
+}
+
+// Cortes alrededor de cada delimitador, de dos en dos: CRLF y boundary en tres trozos
+void testDelimiterPairs(const std::string& name, const std::string& body, const std::string& content) {
+    std::vector<size_t> edges;
+    for (size_t at = body.find("\r\n--XYZ"); at != std::string::npos; at = body.find("\r\n--XYZ", at + 1)) {
+        for (size_t i = at; i <= at + 9 && i < body.size(); i++) edges.push_back(i);
+    }
+    size_t failed = 0;
+    std::string first_problem;
+    for (size_t a = 0; a < edges.size(); a++) {
+        for (size_t b = a + 1; b < edges.size(); b++) {
+            if (edges[b] <= edges[a]) continue;
+            std::string problem = parse(body, {edges[a], edges[b]}, content);
+            if (!problem.empty() && failed++ == 0) {
+                first_problem = "cortes en " + std::to_string(edges[a]) + "," + std::to_string(edges[b]) + ": " + problem;
+            }
+        }
+    }
+    expect(name + ", pares de cortes en los delimitadores", failed == 0,
+           failed == 0 ? "" : std::to_string(failed) + " fallos; " + first_problem);
+}
+
+// Un body cortado antes del boundary final no publica nada ni deja staging
+void testTruncated(const std::string& body) {
+    // Cada corte escribe su error en std::cerr
+    std::streambuf* console = std::cerr.rdbuf(nullptr);
+    size_t end = body.find("\r\n--XYZ--");
+    size_t failed = 0;
+    for (size_t length = 0; length < end + 9; length++) {
+        {
+            MultipartStreamParser parser(CONTENT_TYPE, staging_dir);
+            parser.feed(body.data(), length);
+            if (parser.finish()) failed++;
+        }
+        if (stagingCount() != 0) failed++;
+    }
+    std::cerr.rdbuf(console);
+    std::cerr.clear();
+    expect("body truncado", failed == 0, failed == 0 ? "" : std::to_string(failed) + " fallos");
+}
+
+void testErrors() {
+    {
+        MultipartStreamParser parser("multipart/form-data", staging_dir);
+        expect("Content-Type sin boundary", parser.hasError());
+    }
+    {
+        MultipartStreamParser parser(CONTENT_TYPE, staging_dir);
+        std::string body = "--XYZ\r\nContent-Disposition: form-data; name=\"comment\"\r\n\r\nsolo texto\r\n--XYZ--";
+        parser.feed(body.data(), body.size());
+        expect("sin parte de archivo", !parser.finish() && !parser.hasFile());
+    }
+    {
+        MultipartStreamParser parser(CONTENT_TYPE, staging_dir);
+        std::string body = "--XYZ\r\nContent-Disposition: form-data; name=\"file\"; filename=\"a\"\r\n\r\nx\r\n--XYZoops";
+        parser.feed(body.data(), body.size());
+        expect("boundary malformado", parser.hasError() && !parser.finish());
+    }
+    expect("sin stagings tras los errores", stagingCount() == 0);
+}
+
+} // namespace
+
+int main() {
+    char dir_template[] = "/tmp/autosync_multipart_XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        perror("mkdtemp");
+        return 2;
+    }
+    staging_dir = dir_template;
+
+    std::string content = trickyContent();
+    for (bool with_preamble : {false, true}) {
+        std::string name = with_preamble ? "con preámbulo y epílogo" : "sin preámbulo";
+        std::string body = makeBody(content, with_preamble);
+        testEverySplit(name, body, content);
+        testByteByByte(name, body, content);
+        testDelimiterPairs(name, body, content);
+    }
+    testEverySplit("archivo vacío", makeBody("", true), "");
+    testTruncated(makeBody(content, true));
+    testErrors();
+
+    // Más grande que el buffer de escritura: varios volcados al staging, con
+    // trozos que no coinciden con su tamaño
+    std::string large;
+    while (large.size() < 600 * 1024) large += content + std::to_string(large.size());
+    std::string large_body = makeBody(large, true);
+    for (size_t chunk : {1000, 4096, 65536, 7919}) {
+        std::vector<size_t> cuts;
+        for (size_t at = chunk; at < large_body.size(); at += chunk) cuts.push_back(at);
+        std::string problem = parse(large_body, cuts, large);
+        expect("600 KB en trozos de " + std::to_string(chunk), problem.empty(), problem);
+    }
+
+    fs::remove_all(staging_dir);
+    return failures == 0 ? 0 : 1;
+}
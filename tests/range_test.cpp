@@ -0,0 +1,217 @@
+// Range en las descargas: HttpRange::parse, If-Range y los helpers de
+// cabeceras directamente, y después las respuestas 206/416 y el cuerpo
+// multipart/byteranges que arma startDownload contra una copia del servidor.
+//
+// Uso: range_test <ruta a auto_sync_server>
+
+#include "TestServer.h"
+#include "HttpRange.h"
+#include <vector>
+
+using namespace TestServer;
+
+namespace {
+
+std::string describe(RangeRequest result, const std::vector<ByteRange>& ranges) {
+    std::string text = result == RangeRequest::None ? "None"
+                     : result == RangeRequest::Satisfiable ? "Satisfiable" : "Unsatisfiable";
+    for (const auto& range : ranges) {
+        text += " " + std::to_string(range.first) + "-" + std::to_string(range.last);
+    }
+    return text;
+}
+
+// expected: como lo escribe describe(), p. ej. "Satisfiable 0-9 20-29"
+void expectParse(const std::string& header, size_t file_size, const std::string& expected) {
+    std::vector<ByteRange> ranges;
+    std::string result = describe(HttpRange::parse(header, file_size, ranges), ranges);
+    expect("parse(\"" + header + "\", " + std::to_string(file_size) + ")", result == expected,
+           result + (result == expected ? "" : " (esperado " + expected + ")"));
+}
+
+void testParse() {
+    // Un rango cerrado; el final se recorta al tamaño del archivo
+    expectParse("bytes=0-99", 1000, "Satisfiable 0-99");
+    expectParse("bytes=500-5000", 1000, "Satisfiable 500-999");
+    expectParse(" Bytes = 0-1 ", 1000, "None");
+    expectParse("  bytes=0-1 ,  3-4 ", 1000, "Satisfiable 0-1 3-4");
+
+    // Abierto: desde first hasta el final
+    expectParse("bytes=900-", 1000, "Satisfiable 900-999");
+    expectParse("bytes=0-", 1000, "Satisfiable 0-999");
+    expectParse("bytes=999-", 1000, "Satisfiable 999-999");
+
+    // Sufijo: los últimos N bytes, o el archivo entero si N es mayor
+    expectParse("bytes=-100", 1000, "Satisfiable 900-999");
+    expectParse("bytes=-1000", 1000, "Satisfiable 0-999");
+    expectParse("bytes=-5000", 1000, "Satisfiable 0-999");
+
+    // 416: ningún rango cae dentro del archivo
+    expectParse("bytes=1000-", 1000, "Unsatisfiable");
+    expectParse("bytes=1000-1100,2000-", 1000, "Unsatisfiable");
+    expectParse("bytes=-0", 1000, "Unsatisfiable");
+    expectParse("bytes=0-", 0, "Unsatisfiable");
+    expectParse("bytes=-10", 0, "Unsatisfiable");
+    // ...pero basta con que uno lo sea
+    expectParse("bytes=1000-,0-0", 1000, "Satisfiable 0-0");
+
+    // Inválidos: se ignora la cabecera y se sirve el archivo completo
+    expectParse("items=0-1", 1000, "None");
+    expectParse("bytes=", 1000, "None");
+    expectParse("bytes=abc", 1000, "None");
+    expectParse("bytes=5-1", 1000, "None");
+    expectParse("bytes=1-x", 1000, "None");
+    expectParse("bytes=--5", 1000, "None");
+    std::string many = "bytes=0-0";
+    for (size_t i = 1; i <= HttpRange::MAX_RANGES; i++) many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+    std::vector<ByteRange> ranges;
+    RangeRequest result = HttpRange::parse(many, 1000, ranges);
+    expect("parse(" + std::to_string(HttpRange::MAX_RANGES + 1) + " rangos)", result == RangeRequest::None,
+           describe(result, {}));
+
+    // Se ordenan y se fusionan los solapados, contenidos y contiguos
+    expectParse("bytes=50-59,0-9", 1000, "Satisfiable 0-9 50-59");
+    expectParse("bytes=0-10,5-20", 1000, "Satisfiable 0-20");
+    expectParse("bytes=0-100,10-20", 1000, "Satisfiable 0-100");
+    expectParse("bytes=0-9,10-19", 1000, "Satisfiable 0-19");
+    expectParse("bytes=0-9,11-19", 1000, "Satisfiable 0-9 11-19");
+    expectParse("bytes=20-29,0-9,10-19", 1000, "Satisfiable 0-29");
+    expectParse("bytes=-100,850-949", 1000, "Satisfiable 850-999");
+    expectParse("bytes=0-0,0-0", 1000, "Satisfiable 0-0");
+}
+
+void testValidators() {
+    struct stat st {};
+    st.st_size = 1000;
+    st.st_ino = 42;
+    st.st_mtim.tv_sec = 0;
+    std::string etag = HttpRange::makeETag(st);
+    std::string last_modified = HttpRange::lastModified(st);
+    expect("lastModified(epoch)", last_modified == "Thu, 01 Jan 1970 00:00:00 GMT", last_modified);
+    expect("makeETag es fuerte", etag.size() > 2 && etag.front() == '"' && etag.back() == '"', etag);
+
+    struct stat changed = st;
+    changed.st_mtim.tv_nsec = 1;
+    expect("makeETag cambia con el mtime", HttpRange::makeETag(changed) != etag);
+    changed = st;
+    changed.st_size = 1001;
+    expect("makeETag cambia con el tamaño", HttpRange::makeETag(changed) != etag);
+
+    expect("ifRangeMatches(sin If-Range)", HttpRange::ifRangeMatches("", etag, last_modified));
+    expect("ifRangeMatches(ETag igual)", HttpRange::ifRangeMatches(etag, etag, last_modified));
+    expect("ifRangeMatches(ETag con espacios)", HttpRange::ifRangeMatches(" " + etag + " ", etag, last_modified));
+    expect("ifRangeMatches(otra ETag)", !HttpRange::ifRangeMatches("\"otra\"", etag, last_modified));
+    expect("ifRangeMatches(ETag débil)", !HttpRange::ifRangeMatches("W/" + etag, etag, last_modified));
+    expect("ifRangeMatches(fecha igual)", HttpRange::ifRangeMatches(last_modified, etag, last_modified));
+    expect("ifRangeMatches(otra fecha)",
+           !HttpRange::ifRangeMatches("Fri, 02 Jan 1970 00:00:00 GMT", etag, last_modified));
+}
+
+void testHeaders() {
+    std::string content_range = HttpRange::contentRange({0, 99}, 1000);
+    expect("contentRange", content_range == "bytes 0-99/1000", content_range);
+    std::string a = HttpRange::makeBoundary();
+    std::string b = HttpRange::makeBoundary();
+    expect("makeBoundary", a.compare(0, 9, "autosync_") == 0 && a.size() == 25 && a != b, a + " " + b);
+}
+
+// Cuerpo multipart/byteranges que debe llegar para esos rangos
+std::string byteranges(const std::string& boundary, const std::string& content,
+                       const std::vector<ByteRange>& ranges) {
+    std::string body;
+    for (const auto& range : ranges) {
+        body += "\r\n--" + boundary + "\r\nContent-Type: application/octet-stream\r\n"
+                "Content-Range: " + HttpRange::contentRange(range, content.size()) + "\r\n\r\n" +
+                content.substr(range.first, range.length());
+    }
+    return body + "\r\n--" + boundary + "--\r\n";
+}
+
+void testDownloads() {
+    std::string content(1000, '\0');
+    for (size_t i = 0; i < content.size(); i++) content[i] = static_cast<char>('a' + i * 7 % 26);
+    std::string multipart = "--b\r\nContent-Disposition: form-data; name=\"file\"; filename=\"r.txt\"\r\n"
+                            "Content-Type: text/plain\r\n\r\n" + content + "\r\n--b--\r\n";
+    std::string path = "/api/download/" + jsonString(check("POST /api/upload", 200,
+        request("POST", "/api/upload", multipart, "multipart/form-data; boundary=b")), "filename");
+
+    auto ranged = [&](const std::string& name, int expected, const std::string& headers) {
+        return check("GET " + name, expected, request("GET", path, "", "", headers));
+    };
+    auto expectBody = [](const std::string& name, const std::string& response, const std::string& body) {
+        bool same = bodyOf(response) == body;
+        expect(name, same, same ? "mismo contenido" : "contenido distinto");
+    };
+    auto expectHeader = [](const std::string& name, const std::string& response, const std::string& header,
+                           const std::string& value) {
+        std::string actual = headerValue(response, header);
+        expect(name + " " + header, actual == value, actual);
+    };
+
+    std::string full = ranged("sin Range", 200, "");
+    expectBody("sin Range", full, content);
+    expectHeader("sin Range", full, "Accept-Ranges", "bytes");
+    std::string etag = headerValue(full, "ETag");
+    std::string last_modified = headerValue(full, "Last-Modified");
+
+    std::string first = ranged("bytes=0-9", 206, "Range: bytes=0-9\r\n");
+    expectHeader("bytes=0-9", first, "Content-Range", "bytes 0-9/1000");
+    expectHeader("bytes=0-9", first, "Content-Length", "10");
+    expectBody("bytes=0-9", first, content.substr(0, 10));
+    std::string open_ended = ranged("bytes=990-", 206, "Range: bytes=990-\r\n");
+    expectHeader("bytes=990-", open_ended, "Content-Range", "bytes 990-999/1000");
+    expectBody("bytes=990-", open_ended, content.substr(990));
+    std::string suffix = ranged("bytes=-25", 206, "Range: bytes=-25\r\n");
+    expectHeader("bytes=-25", suffix, "Content-Range", "bytes 975-999/1000");
+    expectBody("bytes=-25", suffix, content.substr(975));
+    // Dos rangos que se fusionan en uno: respuesta de un solo rango, sin multipart
+    std::string merged = ranged("bytes=0-9,10-19", 206, "Range: bytes=0-9,10-19\r\n");
+    expectHeader("bytes=0-9,10-19", merged, "Content-Range", "bytes 0-19/1000");
+    expectBody("bytes=0-9,10-19", merged, content.substr(0, 20));
+
+    std::string unsatisfiable = ranged("bytes=1000-", 416, "Range: bytes=1000-\r\n");
+    expectHeader("bytes=1000-", unsatisfiable, "Content-Range", "bytes */1000");
+    // Crow pone la línea de estado como cuerpo de los errores vacíos; el archivo no se envía
+    expect("bytes=1000- sin contenido", bodyOf(unsatisfiable).find(content.substr(0, 20)) == std::string::npos);
+    expectBody("bytes=abc", ranged("bytes=abc", 200, "Range: bytes=abc\r\n"), content);
+
+    // multipart/byteranges: partes en orden, ya fusionadas, y Content-Length exacto
+    std::string multi = ranged("bytes=500-509,0-9,5-14,-10", 206, "Range: bytes=500-509,0-9,5-14,-10\r\n");
+    std::string content_type = headerValue(multi, "Content-Type");
+    const std::string prefix = "multipart/byteranges; boundary=";
+    expect("multirango Content-Type", content_type.compare(0, prefix.size(), prefix) == 0, content_type);
+    std::string boundary = content_type.substr(std::min(prefix.size(), content_type.size()));
+    std::string expected = byteranges(boundary, content, {{0, 14}, {500, 509}, {990, 999}});
+    expectBody("multirango", multi, expected);
+    expectHeader("multirango", multi, "Content-Length", std::to_string(expected.size()));
+
+    // If-Range: el Range solo vale si el validador es el de la versión actual
+    expectBody("If-Range ETag", ranged("If-Range ETag", 206, "Range: bytes=0-9\r\nIf-Range: " + etag + "\r\n"),
+               content.substr(0, 10));
+    expectBody("If-Range fecha", ranged("If-Range fecha", 206,
+               "Range: bytes=0-9\r\nIf-Range: " + last_modified + "\r\n"), content.substr(0, 10));
+    expectBody("If-Range otra ETag", ranged("If-Range otra ETag", 200,
+               "Range: bytes=0-9\r\nIf-Range: \"otra\"\r\n"), content);
+    expectBody("If-Range ETag débil", ranged("If-Range ETag débil", 200,
+               "Range: bytes=0-9\r\nIf-Range: W/" + etag + "\r\n"), content);
+    // Sin coincidencia tampoco hay 416: se envía el archivo completo
+    ranged("If-Range otra ETag, bytes=1000-", 200, "Range: bytes=1000-\r\nIf-Range: \"otra\"\r\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "uso: " << argv[0] << " <auto_sync_server>" << std::endl;
+        return 2;
+    }
+
+    testParse();
+    testValidators();
+    testHeaders();
+
+    fs::path dir;
+    if (!start(argv[1], dir)) return 1;
+    testDownloads();
+    return stop(dir);
+}